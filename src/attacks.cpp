@@ -1,11 +1,13 @@
 #include "attacks.h"
 #include "common.h"
 
+#include <array>
 #include <cassert>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <tuple>
+#include <vector>
 
 using std::vector;
 
@@ -3,8 +3,11 @@
 #include "fen.h"
 #include "move.h"
 #include "piece.h"
+#include "psqt.h"
 #include "zobrist.h"
 
+#include <array>
+#include <cassert>
 #include <cstdlib>
 #include <iostream>
 #include <map>
@@ -19,7 +22,8 @@ const std::map<const Variant, const std::string> variant_fen_map = {
 Board::Board(const Variant variant)
     : Board(variant, variant_fen_map.at(variant)) {}
 
-Board::Board(const Variant variant, const std::string& fen) {
+Board::Board(const Variant variant, const std::string& fen)
+    : psqt_(&psqt::Get(variant)) {
   castling_allowed_ = true;
   MoveStackEntry* top = move_stack_.Top();
   top->castle = 0xF;
@@ -37,6 +41,8 @@ Board::Board(const Variant variant, const std::string& fen) {
 
   std::fill(std::begin(bitboard_sides_), std::end(bitboard_sides_), 0ULL);
   std::fill(std::begin(bitboard_pieces_), std::end(bitboard_pieces_), 0ULL);
+  std::fill(std::begin(material_), std::end(material_), 0);
+  std::fill(std::begin(piece_square_value_), std::end(piece_square_value_), 0);
 
   for (int i = 0; i < BOARD_SIZE; ++i) {
     Piece piece = board_array_[i];
@@ -46,6 +52,10 @@ Board::Board(const Variant variant, const std::string& fen) {
     const U64 b = (1ULL << i);
     bitboard_sides_[SideIndex(PieceSide(piece))] |= b;
     bitboard_pieces_[PieceIndex(piece)] |= b;
+    material_[SideIndex(PieceSide(piece))] +=
+        psqt_->material[PieceIndex(piece)];
+    piece_square_value_[SideIndex(PieceSide(piece))] +=
+        psqt_->square[PieceIndex(piece)][i];
   }
 
   top->zobrist_key = GenerateZobristKey();
@@ -70,6 +80,10 @@ void Board::MakeMove(const Move& move) {
   top->ep_index = prev->ep_index;
   top->zobrist_key = prev->zobrist_key;
   top->castle = prev->castle;
+  top->reversible_plies =
+      (dest_piece != NULLPIECE || PieceType(src_piece) == PAWN)
+          ? 0
+          : prev->reversible_plies + 1;
 
   // If previous move was a 2 space pawn move, update zobrist key. This is
   // to distinguish between two boards with same piece positions but different
@@ -78,6 +92,16 @@ void Board::MakeMove(const Move& move) {
     top->zobrist_key ^= zobrist::EP(top->ep_index);
   }
 
+  // Update castling rights. A promotion capturing a rook on its home square
+  // also takes away castling rights, so this has to happen before pawn moves
+  // are handled.
+  if (const unsigned char castle = CastleAfterMove(move);
+      castle != top->castle) {
+    top->zobrist_key ^=
+        zobrist::Castling(top->castle) ^ zobrist::Castling(castle);
+    top->castle = castle;
+  }
+
   // Remove piece at source square and destination square (if any).
   RemovePiece(from_index);
   if (dest_piece != NULLPIECE) {
@@ -105,92 +129,92 @@ void Board::MakeMove(const Move& move) {
     return;
   }
 
-  // Handle castling.
-  if (castling_allowed_) {
-    unsigned char castling_bit_king, castling_bit_queen;
-    switch (side_to_move_) {
-    case Side::BLACK:
-      castling_bit_king = top->castle & 0x4;
-      castling_bit_queen = top->castle & 0x8;
-      break;
-
-    case Side::WHITE:
-      castling_bit_king = top->castle & 0x1;
-      castling_bit_queen = top->castle & 0x2;
-      break;
-
-    default:
-      throw std::runtime_error("Invalid side.");
-    }
+  // When king is moved by more than one space, it is for castling so move the
+  // rook to appropriate square.
+  if (castling_allowed_ && PieceType(src_piece) == KING &&
+      abs(to_col - from_col) > 1) {
+    const int rook_index = INDX(from_row, to_col > from_col ? 7 : 0);
+    const Piece rook = board_array_[rook_index];
+    RemovePiece(rook_index);
+    PlacePiece(INDX(from_row, (to_col + from_col) >> 1), rook);
+  }
 
-    const unsigned char castling_bits = castling_bit_king | castling_bit_queen;
-
-    // If castling is possible for the current side.
-    if (castling_bits) {
-
-      // Update castling data if the moving piece is king or rook.
-      switch (PieceType(src_piece)) {
-      case KING:
-        if (abs(to_col - from_col) > 1) {
-          // When king is moved by more than one space, it is for castling so
-          // move the rook to appropriate square.
-          const int rook_index = INDX(from_row, to_col > from_col ? 7 : 0);
-          const Piece rook = board_array_[rook_index];
-          RemovePiece(rook_index);
-          PlacePiece(INDX(from_row, (to_col + from_col) >> 1), rook);
-        }
-        // Update castle and zobrist. This will only happen first time king is
-        // moved, as for later movements of king 'castling_bits' will be 0 and
-        // we'll not reach this point.
-        top->castle &= ~castling_bits;
-        top->zobrist_key ^= zobrist::Castling(top->castle);
-        break;
-
-      case ROOK:
-        // Depending on which rook is moved, mask the relevant bit in 'castle'
-        // and update zobrist key.
-        if (from_col == 0 && castling_bit_queen) {
-          top->castle &= ~castling_bit_queen;
-          top->zobrist_key ^= zobrist::Castling(top->castle);
-        } else if (from_col == 7 && castling_bit_king) {
-          top->castle &= ~castling_bit_king;
-          top->zobrist_key ^= zobrist::Castling(top->castle);
-        }
-        break;
-      }
-    }
+  top->ep_index = -1;
+  PlacePiece(to_index, src_piece);
+  FlipSideToMove();
+}
 
-    // If destination piece is ROOK on it's home index, update opponent
-    // castling rights.
-    if (PieceType(dest_piece) == ROOK) {
-      switch (side_to_move_) {
-      case Side::BLACK:
-        if (to_index == 0) {
-          top->castle &= ~0x2U;
-        } else if (to_index == 7) {
-          top->castle &= ~0x1U;
-        }
-        break;
+U64 Board::ZobristKeyAfter(const Move& move) const {
+  const int from_index = move.from_index();
+  const int to_index = move.to_index();
+  const int from_row = ROW(from_index);
+  const int from_col = COL(from_index);
+  const int to_row = ROW(to_index);
+  const int to_col = COL(to_index);
+  const Piece src_piece = board_array_[from_index];
+  const Piece dest_piece = board_array_[to_index];
+  const MoveStackEntry* top = move_stack_.Top();
 
-      case Side::WHITE:
-        if (to_index == 56) {
-          top->castle &= ~0x8U;
-        } else if (to_index == 63) {
-          top->castle &= ~0x4U;
-        }
-        break;
+  // Mirrors the zobrist key updates in MakeMove().
+  U64 zkey = top->zobrist_key ^ zobrist::Turn();
+  if (top->ep_index != -1) {
+    zkey ^= zobrist::EP(top->ep_index);
+  }
+  zkey ^= zobrist::Castling(top->castle) ^
+          zobrist::Castling(CastleAfterMove(move));
+  zkey ^= zobrist::Get(src_piece, from_index);
+  if (dest_piece != NULLPIECE) {
+    zkey ^= zobrist::Get(dest_piece, to_index);
+  }
 
-      default:
-        throw std::runtime_error("Unknown side to move");
-      }
+  if (PieceType(src_piece) == PAWN) {
+    if (abs(to_row - from_row) == 2) {
+      zkey ^= zobrist::EP(INDX((to_row + from_row) >> 1, to_col));
+    } else if (from_col != to_col && dest_piece == NULLPIECE) {
+      const int ep_capture_index = INDX(from_row, to_col);
+      zkey ^= zobrist::Get(board_array_[ep_capture_index], ep_capture_index);
     }
+    return zkey ^ zobrist::Get(move.is_promotion()
+                                   ? PieceOfSide(move.promoted_piece(),
+                                                 side_to_move_)
+                                   : src_piece,
+                               to_index);
   }
 
+  if (castling_allowed_ && PieceType(src_piece) == KING &&
+      abs(to_col - from_col) > 1) {
+    const int rook_index = INDX(from_row, to_col > from_col ? 7 : 0);
+    const Piece rook = board_array_[rook_index];
+    zkey ^= zobrist::Get(rook, rook_index) ^
+            zobrist::Get(rook, INDX(from_row, (to_col + from_col) >> 1));
+  }
+  return zkey ^ zobrist::Get(src_piece, to_index);
+}
+
+void Board::MakeNullMove() {
+  move_stack_.Push();
+
+  MoveStackEntry* top = move_stack_.Top();
+  const MoveStackEntry* prev = move_stack_.Seek(1);
+  top->move = Move();
+  top->captured_piece = NULLPIECE;
   top->ep_index = -1;
-  PlacePiece(to_index, src_piece);
+  top->zobrist_key = prev->zobrist_key;
+  top->castle = prev->castle;
+  top->reversible_plies = 0;
+
+  // En passant capture is only possible right after the two space pawn move.
+  if (prev->ep_index != -1) {
+    top->zobrist_key ^= zobrist::EP(prev->ep_index);
+  }
   FlipSideToMove();
 }
 
+void Board::UnmakeNullMove() {
+  assert(LastMoveIsNull());
+  UnmakeLastMove();
+}
+
 bool Board::UnmakeLastMove() {
   if (!move_stack_.Size()) {
     return false;
@@ -198,6 +222,11 @@ bool Board::UnmakeLastMove() {
   FlipSideToMove();
 
   const MoveStackEntry* top = move_stack_.Top();
+  if (!top->move.is_valid()) {
+    // Null move.
+    move_stack_.Pop();
+    return true;
+  }
   const Move& move = top->move;
   const int from_index = move.from_index();
   const int to_index = move.to_index();
@@ -240,6 +269,17 @@ bool Board::UnmakeLastMove() {
   return true;
 }
 
+bool Board::IsRepetition() const {
+  const MoveStackEntry* top = move_stack_.Top();
+  // It takes at least four plies for both sides to return to a position.
+  for (int i = 4; i <= top->reversible_plies; i += 2) {
+    if (move_stack_.Seek(i)->zobrist_key == top->zobrist_key) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool Board::CanCastle(const Side side, const Piece piece_type) const {
   if (side == Side::NONE || (piece_type != KING && piece_type != QUEEN)) {
     throw std::runtime_error("Bad parameters");
@@ -315,6 +355,29 @@ void Board::FlipSideToMove() {
   move_stack_.Top()->zobrist_key ^= zobrist::Turn();
 }
 
+unsigned char Board::CastleAfterMove(const Move& move) const {
+  // Castling rights lost when a piece moves from or to the square. While a
+  // right is held, the king and the rook are on their home squares, so moving
+  // from one of these squares moves the king or rook, and moving to a rook's
+  // home square captures it.
+  static constexpr auto castle_masks = [] {
+    std::array<unsigned char, BOARD_SIZE> masks{};
+    masks[INDX(0, 0)] = 0x2;
+    masks[INDX(0, 4)] = 0x3;
+    masks[INDX(0, 7)] = 0x1;
+    masks[INDX(7, 0)] = 0x8;
+    masks[INDX(7, 4)] = 0xC;
+    masks[INDX(7, 7)] = 0x4;
+    return masks;
+  }();
+  const unsigned char castle = move_stack_.Top()->castle;
+  if (!castling_allowed_ || !castle) {
+    return castle;
+  }
+  return castle & ~(castle_masks[move.from_index()] |
+                    castle_masks[move.to_index()]);
+}
+
 U64 Board::GenerateZobristKey() {
   U64 zkey = 0;
   for (int i = 0; i < BOARD_SIZE; ++i) {
@@ -327,37 +390,41 @@ U64 Board::GenerateZobristKey() {
     zkey ^= zobrist::Turn();
   }
   zkey ^= zobrist::Castling(move_stack_.Top()->castle);
+  if (move_stack_.Top()->ep_index != -1) {
+    zkey ^= zobrist::EP(move_stack_.Top()->ep_index);
+  }
   return zkey;
 }
 
 void Board::PlacePiece(const int index, const Piece piece) {
-  board_array_[index] = piece;
-  const U64 bit_mask = (1ULL << index);
-  bitboard_sides_[SideIndex(PieceSide(piece))] |= bit_mask;
-  bitboard_pieces_[PieceIndex(piece)] |= bit_mask;
+  PlacePieceNoZ(index, piece);
   move_stack_.Top()->zobrist_key ^= zobrist::Get(piece, index);
 }
 
 void Board::PlacePieceNoZ(const int index, const Piece piece) {
   board_array_[index] = piece;
   const U64 bit_mask = (1ULL << index);
-  bitboard_sides_[SideIndex(PieceSide(piece))] |= bit_mask;
-  bitboard_pieces_[PieceIndex(piece)] |= bit_mask;
+  const int side_index = SideIndex(PieceSide(piece));
+  const int piece_index = PieceIndex(piece);
+  bitboard_sides_[side_index] |= bit_mask;
+  bitboard_pieces_[piece_index] |= bit_mask;
+  material_[side_index] += psqt_->material[piece_index];
+  piece_square_value_[side_index] += psqt_->square[piece_index][index];
 }
 
 void Board::RemovePiece(const int index) {
-  const Piece piece = board_array_[index];
-  board_array_[index] = NULLPIECE;
-  const U64 bit_mask = ~(1ULL << index);
-  bitboard_sides_[SideIndex(PieceSide(piece))] &= bit_mask;
-  bitboard_pieces_[PieceIndex(piece)] &= bit_mask;
-  move_stack_.Top()->zobrist_key ^= zobrist::Get(piece, index);
+  move_stack_.Top()->zobrist_key ^= zobrist::Get(board_array_[index], index);
+  RemovePieceNoZ(index);
 }
 
 void Board::RemovePieceNoZ(const int index) {
   const Piece piece = board_array_[index];
   board_array_[index] = NULLPIECE;
   const U64 bit_mask = ~(1ULL << index);
-  bitboard_sides_[SideIndex(PieceSide(piece))] &= bit_mask;
-  bitboard_pieces_[PieceIndex(piece)] &= bit_mask;
+  const int side_index = SideIndex(PieceSide(piece));
+  const int piece_index = PieceIndex(piece);
+  bitboard_sides_[side_index] &= bit_mask;
+  bitboard_pieces_[piece_index] &= bit_mask;
+  material_[side_index] -= psqt_->material[piece_index];
+  piece_square_value_[side_index] -= psqt_->square[piece_index][index];
 }
@@ -4,6 +4,7 @@
 #include "common.h"
 #include "move.h"
 #include "piece.h"
+#include "psqt.h"
 
 #include <string>
 
@@ -23,6 +24,18 @@ public:
   // If no move is present in move stack, returns false.
   bool UnmakeLastMove();
 
+  // Passes the turn to the opponent without moving a piece. Used by null-move
+  // pruning; the null move is pushed on the move stack like any other move.
+  void MakeNullMove();
+
+  // Undoes a null move made by MakeNullMove(). Same as UnmakeLastMove().
+  void UnmakeNullMove();
+
+  // Returns true if the last move made was a null move.
+  bool LastMoveIsNull() const {
+    return move_stack_.Size() && !move_stack_.Top()->move.is_valid();
+  }
+
   // Next side to move.
   Side SideToMove() const { return side_to_move_; }
 
@@ -55,21 +68,38 @@ public:
   // Returns the number of pieces of given side on the board.
   int NumPieces(const Side side) const { return PopCount(BitBoard(side)); }
 
+  // Returns the total material value and piece-square value of the pieces of
+  // given side, from the variant's table in psqt.h.
+  int Material(const Side side) const { return material_[SideIndex(side)]; }
+  int PieceSquareValue(const Side side) const {
+    return piece_square_value_[SideIndex(side)];
+  }
+
   // The zobrist key for current board position.
   U64 ZobristKey() const { return move_stack_.Top()->zobrist_key; }
 
+  // Returns the zobrist key of the position after given move, without making
+  // the move. Like MakeMove(), does not check for validity of move.
+  U64 ZobristKeyAfter(const Move& move) const;
+
   // Returns the board as an FEN (Forsyth-Edwards Notation) string.
   std::string ParseIntoFEN() const;
 
   // Returns number of plies played on the board so far.
   int Ply() const { return move_stack_.Size(); }
 
+  // Returns true if the current position occurred before, with the same side
+  // to move. Only the plies since the last capture, pawn move or null move are
+  // scanned, as no earlier position can repeat.
+  bool IsRepetition() const;
+
   void DebugPrintBoard() const;
 
   // WARNING!
   // The below public methods are only useful for EGTB code for offline
-  // processing. They do not handle Zobrist key updates correctly as it is not
-  // required for the EGTB code. For other use cases, handle with care!
+  // processing. They do not handle Zobrist key and material updates correctly
+  // as it is not required for the EGTB code. For other use cases, handle with
+  // care!
 
   void SetPiece(const int index, const Piece piece) {
     board_array_[index] = piece;
@@ -82,6 +112,7 @@ public:
 private:
   // An entry in the move stack.
   struct MoveStackEntry {
+    // Invalid for null moves.
     Move move;
 
     // The piece captured in this move. NULLPIECE if no piece captured.
@@ -97,6 +128,9 @@ private:
 
     // Zobrist key of the board position after this move is played.
     U64 zobrist_key;
+
+    // Number of plies since the last capture, pawn move or null move.
+    int reversible_plies = 0;
   };
 
   // A thin wrapper around an array of MoveStackEntry elements that provides a
@@ -121,13 +155,17 @@ private:
     int size_ = 0;
   };
 
+  // Returns the castling availability after given move is made.
+  unsigned char CastleAfterMove(const Move& move) const;
+
   // Generates Zobrist key for the board. Call this only after the board array,
   // side to move, en-passant target (if any) have been set.
   U64 GenerateZobristKey();
 
   // Places piece on the board. Two versions - one updates zobrist key and
-  // another doesn't. It's an error to call these methods if the square given by
-  // index is not empty.
+  // another doesn't. Both update material and piece-square totals, so these
+  // are restored when a move is undone. It's an error to call these methods if
+  // the square given by index is not empty.
   void PlacePiece(const int index, const Piece piece);
   void PlacePieceNoZ(const int index, const Piece piece);
 
@@ -145,6 +183,11 @@ private:
   U64 bitboard_sides_[2];
   U64 bitboard_pieces_[12];
 
+  // Material and piece-square totals of each side, from psqt_.
+  const psqt::Table* psqt_;
+  int material_[2];
+  int piece_square_value_[2];
+
   // Side to move next.
   Side side_to_move_;
 
@@ -5,6 +5,7 @@
 #include "common.h"
 #include "egtb.h"
 #include "eval.h"
+#include "eval_cache.h"
 #include "eval_normal.h"
 #include "eval_suicide.h"
 #include "extensions.h"
@@ -12,8 +13,10 @@
 #include "lmr.h"
 #include "move_order.h"
 #include "movegen.h"
+#include "null_move.h"
 #include "player.h"
 #include "pn_search.h"
+#include "quiescence.h"
 #include "search_algorithm.h"
 #include "timer.h"
 #include "transpos.h"
@@ -35,6 +38,14 @@ struct BuildOptions {
   // this variable is nullptr, a new transposition table is built.
   TranspositionTable* transpos = nullptr;
 
+  // Use this eval cache instead of building a new one, so that the ponderer
+  // and Lazy SMP helpers share the player's cached evaluations.
+  EvalCache* eval_cache = nullptr;
+
+  // Share the endgame tables loaded by this EGTB instead of loading them
+  // again. Only used by variants that have endgame tables.
+  const EGTB* egtb = nullptr;
+
   bool build_book = true;
 
   int rand_moves = 0;
@@ -42,12 +53,15 @@ struct BuildOptions {
 
 class PlayerBuilder {
 public:
-  PlayerBuilder() : external_transpos_(false) {}
+  PlayerBuilder() : external_transpos_(false), external_eval_cache_(false) {}
 
   virtual ~PlayerBuilder() {
     if (external_transpos_) {
       transpos_.release();
     }
+    if (external_eval_cache_) {
+      eval_cache_.release();
+    }
   }
 
   virtual void BuildBoard() = 0;
@@ -58,13 +72,23 @@ public:
 
   virtual void BuildTranspositionTable() {
     // ~16M entries.
-    transpos_.reset(new TranspositionTable(1U << 23));
+    transpos_.reset(new TranspositionTable(1U << 24));
   }
 
   virtual void InjectExternalTranspositionTable(TranspositionTable* transpos) {
     transpos_.reset(transpos);
     external_transpos_ = true;
   }
+
+  virtual void BuildEvalCache() {
+    eval_cache_.reset(new EvalCache(EvalCache::DEFAULT_SIZE));
+  }
+
+  virtual void InjectExternalEvalCache(EvalCache* eval_cache) {
+    eval_cache_.reset(eval_cache);
+    external_eval_cache_ = true;
+  }
+  virtual void InjectExternalEGTB(const EGTB* egtb) { external_egtb_ = egtb; }
   virtual void BuildTimer() { timer_.reset(new Timer); }
   virtual void BuildSearchAlgorithm() {
     assert(board_ != nullptr);
@@ -123,12 +147,16 @@ protected:
   std::unique_ptr<IterativeDeepener> iterative_deepener_;
   std::unique_ptr<Evaluator> eval_;
   std::unique_ptr<TranspositionTable> transpos_;
+  std::unique_ptr<EvalCache> eval_cache_;
   std::unique_ptr<Timer> timer_;
   std::unique_ptr<Book> book_;
   std::unique_ptr<Extensions> extensions_;
   std::unique_ptr<Player> player_;
   std::unique_ptr<EGTB> egtb_;
   bool external_transpos_;
+  bool external_eval_cache_;
+  // Not owned. Its tables are shared by egtb_ if set.
+  const EGTB* external_egtb_ = nullptr;
 };
 
 class NormalPlayerBuilder : public PlayerBuilder {
@@ -150,6 +178,7 @@ public:
     assert(board_ != nullptr);
     assert(movegen_ != nullptr);
     eval_.reset(new EvalNormal(board_.get(), movegen_.get()));
+    eval_->SetEvalCache(eval_cache_.get());
   }
 
   void BuildBook() override {
@@ -159,7 +188,17 @@ public:
   void AddExtensions() override {
     assert(extensions_ != nullptr);
     assert(board_ != nullptr);
-    extensions_->move_orderer.reset(new CapturesFirstOrderer(board_.get()));
+    extensions_->move_orderer.reset(new HistoryOrderer(
+        board_.get(),
+        std::unique_ptr<MoveOrderer>(new CapturesFirstOrderer(board_.get())),
+        MAX_DEPTH /* base orderer plies */));
+    extensions_->quiescence.reset(
+        new Quiescence(2 * EvalNormal::PieceValue(PAWN) /* delta margin */,
+                       4 /* max depth */));
+    // Not for suicide chess, where zugzwang is everywhere.
+    extensions_->null_move.reset(new NullMove(2 /* reduction */,
+                                              3 /* min depth */,
+                                              6 /* verification depth */));
   }
 
   void BuildPlayer(int rand_moves) override {
@@ -167,10 +206,12 @@ public:
     assert(movegen_ != nullptr);
     assert(iterative_deepener_ != nullptr);
     assert(timer_ != nullptr);
+    assert(transpos_ != nullptr);
     // For Normal player, extensions_ could be NULL as of now.
     player_.reset(new Player(book_.get(), board_.get(), movegen_.get(),
                              iterative_deepener_.get(), timer_.get(),
-                             egtb_.get(), extensions_.get(), rand_moves));
+                             transpos_.get(), egtb_.get(), extensions_.get(),
+                             rand_moves));
   }
 };
 
@@ -192,6 +233,10 @@ public:
 
   void BuildEGTB() override {
     assert(board_ != nullptr);
+    if (external_egtb_) {
+      egtb_.reset(new EGTB(*external_egtb_, *board_.get()));
+      return;
+    }
     std::vector<std::string> egtb_filenames;
     assert(GlobFiles("egtb/*.egtb", &egtb_filenames));
     egtb_.reset(new EGTB(egtb_filenames, *board_.get()));
@@ -201,7 +246,11 @@ public:
   void BuildEvaluator() override {
     assert(board_ != nullptr);
     assert(movegen_ != nullptr);
-    eval_.reset(new EvalSuicide(board_.get(), movegen_.get(), egtb_.get()));
+    // movegen_ was built by BuildMoveGenerator() above.
+    eval_.reset(new EvalSuicide(
+        board_.get(), static_cast<MoveGeneratorSuicide*>(movegen_.get()),
+        egtb_.get()));
+    eval_->SetEvalCache(eval_cache_.get());
   }
 
   void BuildBook() override {
@@ -213,8 +262,13 @@ public:
     assert(movegen_ != nullptr);
     assert(eval_ != nullptr);
     assert(extensions_ != nullptr);
-    extensions_->move_orderer.reset(
-        new MobilityOrderer(board_.get(), movegen_.get()));
+    // Mobility ordering makes every move to count the replies, so it is only
+    // worth it close to the root.
+    extensions_->move_orderer.reset(new HistoryOrderer(
+        board_.get(),
+        std::unique_ptr<MoveOrderer>(
+            new MobilityOrderer(board_.get(), movegen_.get())),
+        2 /* base orderer plies */));
     extensions_->lmr.reset(new LMR(4 /* full depth moves */,
                                    2 /* reduction limit */,
                                    1 /* depth reduction factor */));
@@ -231,10 +285,12 @@ public:
     assert(movegen_ != nullptr);
     assert(iterative_deepener_ != nullptr);
     assert(timer_ != nullptr);
+    assert(transpos_ != nullptr);
     assert(extensions_ != nullptr);
     player_.reset(new Player(book_.get(), board_.get(), movegen_.get(),
                              iterative_deepener_.get(), timer_.get(),
-                             egtb_.get(), extensions_.get(), rand_moves));
+                             transpos_.get(), egtb_.get(), extensions_.get(),
+                             rand_moves));
   }
 
 private:
@@ -252,6 +308,11 @@ public:
     } else {
       player_builder_->BuildTranspositionTable();
     }
+    if (options.eval_cache) {
+      player_builder_->InjectExternalEvalCache(options.eval_cache);
+    } else {
+      player_builder_->BuildEvalCache();
+    }
     if (options.build_book) {
       player_builder_->BuildBook();
     }
@@ -262,6 +323,9 @@ public:
     }
     player_builder_->BuildExtensions(); // Must always be called first.
     player_builder_->BuildMoveGenerator();
+    if (options.egtb) {
+      player_builder_->InjectExternalEGTB(options.egtb);
+    }
     player_builder_->BuildEGTB();
     player_builder_->BuildEvaluator();
     player_builder_->BuildTimer();
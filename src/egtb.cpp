@@ -4,6 +4,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 
 constexpr int piece_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
@@ -54,7 +55,14 @@ EGTB::EGTB(const std::vector<std::string>& egtb_files, const Board& board)
     : egtb_files_(egtb_files), board_(board), initialized_(false),
       egtb_hits_(0ULL), egtb_misses_(0ULL) {}
 
+EGTB::EGTB(const EGTB& egtb, const Board& board)
+    : egtb_files_(egtb.egtb_files_), board_(board),
+      initialized_(egtb.initialized_), egtb_index_(egtb.egtb_index_),
+      egtb_hits_(0ULL), egtb_misses_(0ULL) {}
+
 void EGTB::Initialize() {
+  auto egtb_index =
+      std::make_shared<std::unordered_map<int, std::vector<EGTBIndexEntry>>>();
   for (const std::string& egtb_file : egtb_files_) {
     const auto parts = SplitString(egtb_file, '/');
     int board_desc_id =
@@ -64,8 +72,8 @@ void EGTB::Initialize() {
     ifs.seekg(0, std::ios_base::end);
     const int64_t file_size = ifs.tellg();
     const int num_entries = file_size / sizeof(EGTBIndexEntry);
-    assert(egtb_index_.find(board_desc_id) == egtb_index_.end());
-    auto& v = egtb_index_[board_desc_id];
+    assert(egtb_index->find(board_desc_id) == egtb_index->end());
+    auto& v = (*egtb_index)[board_desc_id];
     v.resize(num_entries);
     ifs.seekg(0, std::ios_base::beg);
     EGTBIndexEntry* tmp = new EGTBIndexEntry[num_entries];
@@ -76,21 +84,22 @@ void EGTB::Initialize() {
     delete[] tmp;
     ifs.close();
   }
+  egtb_index_ = egtb_index;
   initialized_ = true;
 }
 
 const EGTBIndexEntry* EGTB::Lookup() {
   assert(initialized_);
   int board_desc_id = ComputeBoardDescriptionId(board_);
-  auto v = egtb_index_.find(board_desc_id);
-  if (v == egtb_index_.end()) {
+  auto v = egtb_index_->find(board_desc_id);
+  if (v == egtb_index_->end()) {
     return nullptr;
   }
   U64 index = ComputeEGTBIndex(board_);
   if (index >= v->second.size()) {
     return nullptr;
   }
-  EGTBIndexEntry& entry = v->second.at(index);
+  const EGTBIndexEntry& entry = v->second.at(index);
   if (!entry.next_move.is_valid()) {
     ++egtb_misses_;
     return nullptr;
@@ -4,6 +4,7 @@
 #include "board.h"
 #include "move.h"
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -20,6 +21,12 @@ struct EGTBIndexEntry {
 class EGTB {
 public:
   EGTB(const std::vector<std::string>& egtb_files, const Board& board);
+
+  // Looks up positions on 'board' in the tables loaded by 'egtb', which are
+  // shared read-only instead of being loaded again. Lazy SMP helpers and the
+  // ponderer are built this way.
+  EGTB(const EGTB& egtb, const Board& board);
+
   virtual ~EGTB() {}
   void Initialize();
 
@@ -31,7 +38,9 @@ private:
   const std::vector<std::string> egtb_files_;
   const Board& board_;
   bool initialized_;
-  std::unordered_map<int, std::vector<EGTBIndexEntry>> egtb_index_;
+  std::shared_ptr<
+      const std::unordered_map<int, std::vector<EGTBIndexEntry>>>
+      egtb_index_;
   uint64_t egtb_hits_;
   uint64_t egtb_misses_;
 };
@@ -2,6 +2,7 @@
 #define EVAL_H
 
 class Board;
+class EvalCache;
 
 class Evaluator {
 public:
@@ -13,8 +14,14 @@ public:
   // Returns WIN, -WIN or DRAW if game is over; else returns -1.
   virtual int Result() const = 0;
 
+  // Implementations look up scores in given cache before computing them, and
+  // store the scores they compute. May be null.
+  void SetEvalCache(EvalCache* eval_cache) { eval_cache_ = eval_cache; }
+
 protected:
   Evaluator() {}
+
+  EvalCache* eval_cache_ = nullptr;
 };
 
 #endif
@@ -0,0 +1,61 @@
+#ifndef EVAL_CACHE_H
+#define EVAL_CACHE_H
+
+#include "common.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+// Cache of static evaluations keyed by zobrist key. It is kept apart from the
+// transposition table so that leaf evaluations don't evict search results, and
+// is much smaller as an entry is only a score. Each entry is a single word
+// holding the upper half of the zobrist key and the score, so it is always
+// read and written whole: threads may share the cache without locks. Positions
+// that map to the same entry replace each other.
+class EvalCache {
+public:
+  // Default number of entries, 8 MB.
+  static constexpr size_t DEFAULT_SIZE = 1U << 20;
+
+  // 'size' is the number of entries. It is rounded down to a power of two.
+  explicit EvalCache(size_t size) {
+    size_t num_entries = 1U;
+    while (num_entries * 2 <= size) {
+      num_entries *= 2;
+    }
+    entries_.reset(new std::atomic<U64>[num_entries]);
+    mask_ = num_entries - 1;
+    Clear();
+  }
+
+  std::optional<int> Get(U64 zkey) const {
+    const U64 entry = entries_[zkey & mask_].load(std::memory_order_relaxed);
+    if ((entry ^ zkey) >> 32) {
+      return std::nullopt;
+    }
+    return static_cast<int32_t>(entry);
+  }
+
+  void Put(U64 zkey, int score) {
+    entries_[zkey & mask_].store((zkey & KEY_MASK) |
+                                     static_cast<uint32_t>(score),
+                                 std::memory_order_relaxed);
+  }
+
+  void Clear() {
+    for (size_t i = 0; i <= mask_; ++i) {
+      entries_[i].store(0ULL, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  static constexpr U64 KEY_MASK = 0xFFFFFFFF00000000ULL;
+
+  std::unique_ptr<std::atomic<U64>[]> entries_;
+  size_t mask_;
+};
+
+#endif
@@ -1,105 +1,69 @@
 #include "eval_normal.h"
 #include "board.h"
 #include "common.h"
+#include "eval_cache.h"
 #include "movegen.h"
 #include "piece.h"
+#include "psqt.h"
 #include "stopwatch.h"
 
 namespace {
-// Piece values.
-namespace pv {
-const int KING = 0;
-const int QUEEN = 9;
-const int ROOK = 5;
-const int BISHOP = 3;
-const int KNIGHT = 3;
-const int PAWN = 1;
-} // namespace pv
-
 const int MATERIAL_FACTOR = 25;
 
 // These values are basically crap.
 const int OPENING_PAWNS_STRENGTH_FACTOR = 4;
 const int MIDDLE_PAWNS_STRENGTH_FACTOR = 2;
-
-// clang-format off
-const int sq_strength[] = {
-  1, 1, 1, 1, 1, 1, 1, 1,
-  1, 2, 2, 2, 2, 2, 2, 1,
-  1, 2, 3, 3, 3, 3, 2, 1,
-  1, 2, 3, 5, 5, 3, 2, 1,
-  1, 2, 3, 5, 5, 3, 2, 1,
-  1, 2, 3, 3, 3, 3, 3, 1,
-  1, 2, 2, 2, 2, 2, 2, 1,
-  1, 1, 1, 1, 1, 1, 1, 1
-};
-// clang-format on
-
 } // namespace
 
-int EvalNormal::PieceValDifference() const {
-  const int white_val = PopCount(board_->BitBoard(KING)) * pv::KING +
-                        PopCount(board_->BitBoard(QUEEN)) * pv::QUEEN +
-                        PopCount(board_->BitBoard(PAWN)) * pv::PAWN +
-                        PopCount(board_->BitBoard(BISHOP)) * pv::BISHOP +
-                        PopCount(board_->BitBoard(KNIGHT)) * pv::KNIGHT +
-                        PopCount(board_->BitBoard(ROOK)) * pv::ROOK;
-  const int black_val = PopCount(board_->BitBoard(-KING)) * pv::KING +
-                        PopCount(board_->BitBoard(-QUEEN)) * pv::QUEEN +
-                        PopCount(board_->BitBoard(-PAWN)) * pv::PAWN +
-                        PopCount(board_->BitBoard(-BISHOP)) * pv::BISHOP +
-                        PopCount(board_->BitBoard(-KNIGHT)) * pv::KNIGHT +
-                        PopCount(board_->BitBoard(-ROOK)) * pv::ROOK;
+int EvalNormal::PieceValue(const Piece piece) {
+  return MATERIAL_FACTOR *
+         psqt::Get(Variant::NORMAL).material[PieceIndex(PieceType(piece))];
+}
 
-  return (board_->SideToMove() == Side::WHITE) ? (white_val - black_val)
-                                               : (black_val - white_val);
+int EvalNormal::PieceValDifference() const {
+  const Side side = board_->SideToMove();
+  return board_->Material(side) - board_->Material(OppositeSide(side));
 }
 
 int EvalNormal::Evaluate() {
+  if (eval_cache_) {
+    if (const auto score = eval_cache_->Get(board_->ZobristKey())) {
+      return *score;
+    }
+  }
+  const int score = ComputeScore();
+  if (eval_cache_) {
+    eval_cache_->Put(board_->ZobristKey(), score);
+  }
+  return score;
+}
+
+int EvalNormal::ComputeScore() {
   const Side side = board_->SideToMove();
   MoveArray move_array;
   movegen_->GenerateMoves(&move_array);
   if (move_array.size() == 0) {
-    const U64 attack_map = ComputeAttackMap(*board_, OppositeSide(side));
-    if (attack_map & board_->BitBoard(PieceOfSide(KING, side))) {
-      return -WIN;
-    } else {
-      return DRAW; // stalemate
-    }
+    return InCheck(*board_) ? -WIN : DRAW; // stalemate if not in check
   }
-  int score = MATERIAL_FACTOR * PieceValDifference();
+  // Only checking moves can mate, and only they need the opponent's replies.
   for (size_t i = 0; i < move_array.size(); ++i) {
     const Move& move = move_array.get(i);
-    board_->MakeMove(move);
-    U64 attack_map = ComputeAttackMap(*board_, side);
-    if (attack_map & board_->BitBoard(PieceOfSide(KING, OppositeSide(side)))) {
-      MoveArray opp_move_array;
-      movegen_->GenerateMoves(&opp_move_array);
-      if (opp_move_array.size() == 0) {
-        score = WIN;
-      }
+    if (!GivesCheck(board_, move)) {
+      continue;
     }
+    board_->MakeMove(move);
+    MoveArray opp_move_array;
+    movegen_->GenerateMoves(&opp_move_array);
     board_->UnmakeLastMove();
+    if (opp_move_array.size() == 0) {
+      return WIN;
+    }
   }
-  if (score == WIN) {
-    return score;
-  }
-
-  U64 self_pawns = board_->BitBoard(PieceOfSide(PAWN, side));
-  int self_pawns_strength = 0;
-  while (self_pawns) {
-    const int lsb_index = Lsb1(self_pawns);
-    self_pawns_strength += sq_strength[lsb_index];
-    self_pawns ^= (1ULL << lsb_index);
-  }
+  int score = MATERIAL_FACTOR * PieceValDifference();
 
-  U64 opp_pawns = board_->BitBoard(PieceOfSide(PAWN, OppositeSide(side)));
-  int opp_pawns_strength = 0;
-  while (opp_pawns) {
-    const int lsb_index = Lsb1(opp_pawns);
-    opp_pawns_strength += sq_strength[lsb_index];
-    opp_pawns ^= (1ULL << lsb_index);
-  }
+  // Only pawns have piece-square values in normal chess.
+  const int self_pawns_strength = board_->PieceSquareValue(side);
+  const int opp_pawns_strength = board_->PieceSquareValue(OppositeSide(side));
 
   const int pawns_strength =
       (self_pawns_strength - opp_pawns_strength) *
@@ -125,16 +89,10 @@ int EvalNormal::Evaluate() {
 }
 
 int EvalNormal::Result() const {
-  const Side side = board_->SideToMove();
   MoveArray move_array;
   movegen_->GenerateMoves(&move_array);
   if (move_array.size() == 0) {
-    const U64 attack_map = ComputeAttackMap(*board_, OppositeSide(side));
-    if (attack_map & board_->BitBoard(PieceOfSide(KING, side))) {
-      return -WIN;
-    } else {
-      return DRAW; // stalemate
-    }
+    return InCheck(*board_) ? -WIN : DRAW; // stalemate if not in check
   }
   return -1;
 }
@@ -3,6 +3,7 @@
 
 #include "common.h"
 #include "eval.h"
+#include "piece.h"
 
 class Board;
 class MoveGenerator;
@@ -17,7 +18,13 @@ public:
 
   int Result() const override;
 
+  // Returns the material value of given piece in evaluation score units.
+  static int PieceValue(const Piece piece);
+
 private:
+  // Evaluate() without the eval cache.
+  int ComputeScore();
+
   int PieceValDifference() const;
 
   Board* board_;
@@ -2,6 +2,7 @@
 #include "board.h"
 #include "common.h"
 #include "egtb.h"
+#include "eval_cache.h"
 #include "movegen.h"
 #include "piece.h"
 #include "stopwatch.h"
@@ -9,16 +10,6 @@
 #include <cstdlib>
 
 namespace {
-// Piece values.
-namespace pv {
-constexpr int KING = 10;
-constexpr int QUEEN = 6;
-constexpr int ROOK = 7;
-constexpr int BISHOP = 3;
-constexpr int KNIGHT = 3;
-constexpr int PAWN = 2;
-} // namespace pv
-
 // Weight for mobility.
 constexpr int MOBILITY_FACTOR = 25;
 
@@ -28,21 +19,8 @@ constexpr int TEMPO = 250;
 } // namespace
 
 int EvalSuicide::PieceValDifference() const {
-  const int white_val = PopCount(board_->BitBoard(KING)) * pv::KING +
-                        PopCount(board_->BitBoard(QUEEN)) * pv::QUEEN +
-                        PopCount(board_->BitBoard(PAWN)) * pv::PAWN +
-                        PopCount(board_->BitBoard(BISHOP)) * pv::BISHOP +
-                        PopCount(board_->BitBoard(KNIGHT)) * pv::KNIGHT +
-                        PopCount(board_->BitBoard(ROOK)) * pv::ROOK;
-  const int black_val = PopCount(board_->BitBoard(-KING)) * pv::KING +
-                        PopCount(board_->BitBoard(-QUEEN)) * pv::QUEEN +
-                        PopCount(board_->BitBoard(-PAWN)) * pv::PAWN +
-                        PopCount(board_->BitBoard(-BISHOP)) * pv::BISHOP +
-                        PopCount(board_->BitBoard(-KNIGHT)) * pv::KNIGHT +
-                        PopCount(board_->BitBoard(-ROOK)) * pv::ROOK;
-
-  return (board_->SideToMove() == Side::WHITE) ? (white_val - black_val)
-                                               : (black_val - white_val);
+  const Side side = board_->SideToMove();
+  return board_->Material(side) - board_->Material(OppositeSide(side));
 }
 
 int EvalSuicide::PieceCountDiff() const {
@@ -65,6 +43,19 @@ bool EvalSuicide::RivalBishopsOnOppositeColoredSquares() const {
 }
 
 int EvalSuicide::Evaluate() {
+  if (eval_cache_) {
+    if (const auto score = eval_cache_->Get(board_->ZobristKey())) {
+      return *score;
+    }
+  }
+  const int score = ComputeScore();
+  if (eval_cache_) {
+    eval_cache_->Put(board_->ZobristKey(), score);
+  }
+  return score;
+}
+
+int EvalSuicide::ComputeScore() {
   const Side side = board_->SideToMove();
   const int self_pieces = board_->NumPieces(side);
   const int opp_pieces = board_->NumPieces(OppositeSide(side));
@@ -81,7 +72,8 @@ int EvalSuicide::Evaluate() {
     }
   }
 
-  const int self_moves = movegen_->CountMoves();
+  const SuicideMoveCounts move_counts = movegen_->CountMovesBothSides();
+  const int self_moves = move_counts.num_moves[SideIndex(side)];
   if (self_moves == 0) {
     return self_pieces < opp_pieces ? WIN
                                     : (self_pieces == opp_pieces ? DRAW : -WIN);
@@ -96,9 +88,7 @@ int EvalSuicide::Evaluate() {
     return eval_val;
   }
 
-  board_->FlipSideToMove();
-  const int opp_moves = movegen_->CountMoves();
-  board_->FlipSideToMove();
+  const int opp_moves = move_counts.num_moves[SideIndex(OppositeSide(side))];
   if (opp_moves == 0) {
     MoveArray move_array;
     movegen_->GenerateMoves(&move_array);
@@ -7,11 +7,11 @@
 class Board;
 class EGTB;
 class MoveArray;
-class MoveGenerator;
+class MoveGeneratorSuicide;
 
 class EvalSuicide : public Evaluator {
 public:
-  EvalSuicide(Board* board, MoveGenerator* movegen, EGTB* egtb)
+  EvalSuicide(Board* board, MoveGeneratorSuicide* movegen, EGTB* egtb)
       : board_(board), movegen_(movegen), egtb_(egtb) {}
 
   int Evaluate() override;
@@ -19,6 +19,9 @@ public:
   int Result() const override;
 
 private:
+  // Evaluate() without the eval cache.
+  int ComputeScore();
+
   int PieceValDifference() const;
 
   int PieceCountDiff() const;
@@ -30,7 +33,7 @@ private:
   bool RivalBishopsOnOppositeColoredSquares() const;
 
   Board* board_;
-  MoveGenerator* movegen_;
+  MoveGeneratorSuicide* movegen_;
   EGTB* egtb_;
 };
 
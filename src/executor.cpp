@@ -11,6 +11,7 @@
 #include "player.h"
 #include "transpos.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <sstream>
@@ -25,14 +26,17 @@ namespace {
 
 // All supported Xboard communication protocol commands.
 enum CmdName {
+  CORES,
   ERROR,
   FEATURE,
   FORCE,
   GO,
   INVALID, // if command entered is invalid.
+  MEMORY,
   MOVELIST,
   NEW,
   NOBOOK,
+  NODES,
   NOPNS,
   NOPONDER,
   NOPOST,
@@ -46,6 +50,7 @@ enum CmdName {
   SEARCH_DEPTH,
   SETBOARD,
   SHOWBOARD,
+  SNAPSHOT,
   THINKTIME,
   TIME,
   UNMAKE,
@@ -72,7 +77,9 @@ Command Interpret(const std::string& cmd) {
       {"sd", SEARCH_DEPTH},  {"setboard", SETBOARD},
       {"sb", SHOWBOARD},     {"thinktime", THINKTIME},
       {"time", TIME},        {"usermove", USERMOVE},
-      {"variant", VARIANT},  {"unmake", UNMAKE}};
+      {"variant", VARIANT},  {"unmake", UNMAKE},
+      {"cores", CORES},      {"memory", MEMORY},
+      {"snapshot", SNAPSHOT}, {"nodes", NODES}};
   std::vector<std::string> parts = SplitString(cmd, ' ');
   Command command;
   if (auto cmd_map_kv = cmd_map.find(parts[0]); cmd_map_kv == cmd_map.end()) {
@@ -86,6 +93,9 @@ Command Interpret(const std::string& cmd) {
   return command;
 }
 
+// Entries searched at least this deep are saved in snapshots.
+constexpr int SNAPSHOT_MIN_DEPTH = 6;
+
 // Linear interpolation - given x1, y1, x2, y2 and x3, find y3.
 double Interpolate(double x1, double y1, double x2, double y2, double x3) {
   return y1 + ((y2 - y1) / (x2 - x1)) * (x3 - x1);
@@ -113,6 +123,26 @@ bool Executor::MatchResult(vector<string>* response) {
 }
 
 void Executor::ReBuildPlayer(int rand_moves) {
+  // The ponderer searches with the transposition table that is about to be
+  // cleared.
+  StopPondering();
+  SaveSnapshot();
+  if (!transpos_ || transpos_megabytes_ != hash_megabytes_) {
+    transpos_.reset();
+    transpos_.reset(new TranspositionTable(
+        TranspositionTable::SizeForMegabytes(hash_megabytes_)));
+    transpos_megabytes_ = hash_megabytes_;
+  } else {
+    transpos_->Clear();
+  }
+  transpos_variant_ = variant_;
+  LoadSnapshot();
+  if (!eval_cache_) {
+    eval_cache_.reset(new EvalCache(EvalCache::DEFAULT_SIZE));
+  } else {
+    eval_cache_->Clear();
+  }
+  ponder_move_ = Move();
   switch (variant_) {
   case Variant::NORMAL:
     player_builder_.reset(new NormalPlayerBuilder());
@@ -125,10 +155,13 @@ void Executor::ReBuildPlayer(int rand_moves) {
   PlayerBuilderDirector director(player_builder_.get());
   BuildOptions options;
   options.init_fen = init_fen_;
+  options.transpos = transpos_.get();
+  options.eval_cache = eval_cache_.get();
   options.build_book = book_;
   options.rand_moves = rand_moves;
   player_ = director.Build(options);
   assert(player_ != nullptr);
+  ReBuildHelpers();
 }
 
 void Executor::ReBuildPonderer() {
@@ -147,26 +180,99 @@ void Executor::ReBuildPonderer() {
   PlayerBuilderDirector director(ponderer_builder_.get());
   BuildOptions options;
   options.init_fen = player_->GetBoard()->ParseIntoFEN();
-  options.transpos = player_builder_->GetTranspos();
+  options.transpos = transpos_.get();
+  options.eval_cache = eval_cache_.get();
+  options.egtb = player_builder_->GetEGTB();
   options.build_book = false;
   ponderer_ = director.Build(options);
   assert(ponderer_ != nullptr);
+  // A FEN has no history: copy the board so that the ponderer detects
+  // repetitions and evaluates with the right ply count.
+  *ponderer_->GetBoard() = *player_->GetBoard();
+  // The player's helpers are idle while we ponder.
+  std::vector<Player*> helpers;
+  for (const auto& helper_builder : helper_builders_) {
+    helpers.push_back(helper_builder->GetPlayer());
+  }
+  ponderer_->SetHelpers(helpers);
+}
+
+void Executor::ReBuildHelpers() {
+  helper_builders_.clear();
+  std::vector<Player*> helpers;
+  for (int i = 1; i < num_threads_; ++i) {
+    std::unique_ptr<PlayerBuilder> helper_builder;
+    switch (variant_) {
+    case Variant::NORMAL:
+      helper_builder.reset(new NormalPlayerBuilder());
+      break;
+    case Variant::SUICIDE:
+      helper_builder.reset(new SuicidePlayerBuilder(false));
+      break;
+    }
+    assert(helper_builder.get() != nullptr);
+    PlayerBuilderDirector director(helper_builder.get());
+    BuildOptions options;
+    options.init_fen = player_->GetBoard()->ParseIntoFEN();
+    options.transpos = transpos_.get();
+    options.eval_cache = eval_cache_.get();
+    options.egtb = player_builder_->GetEGTB();
+    options.build_book = false;
+    helpers.push_back(director.Build(options));
+    helper_builders_.push_back(std::move(helper_builder));
+  }
+  player_->SetHelpers(helpers);
+}
+
+void Executor::SaveSnapshot() {
+  if (snapshot_file_.empty() || !transpos_ || !transpos_dirty_) {
+    return;
+  }
+  transpos_->Save(SnapshotFilename(transpos_variant_), transpos_variant_,
+                  SNAPSHOT_MIN_DEPTH);
+  transpos_dirty_ = false;
+}
+
+void Executor::LoadSnapshot() {
+  if (snapshot_file_.empty()) {
+    return;
+  }
+  transpos_->Load(SnapshotFilename(transpos_variant_), transpos_variant_);
+}
+
+std::string Executor::SnapshotFilename(Variant variant) const {
+  return snapshot_file_ +
+         (variant == Variant::SUICIDE ? ".suicide" : ".normal");
 }
 
 void Executor::StartPondering(double time_centis) {
-  if (!ponder_) {
+  // A node-limited search must not depend on how long the ponderer filled
+  // the transposition table, or on the clock after a ponder hit.
+  if (!ponder_ || search_params_.max_nodes > 0) {
     return;
   }
   // Don't ponder if too little time remaining or if already pondering.
   if (time_centis < 500 || pondering_thread_) {
     return;
   }
+  // Nothing to ponder on if the search did not predict a reply, e.g. after a
+  // book move.
+  if (!ponder_move_.is_valid() ||
+      !player_builder_->GetMoveGenerator()->IsValidMove(ponder_move_)) {
+    return;
+  }
+  std::cout << "# Pondering on " << ponder_move_.str() << std::endl;
   ReBuildPonderer();
-  pondering_thread_.reset(new std::thread([this] {
-    SearchParams ponder_params;
-    ponder_params.thinking_output = false;
-    // Just seeding transposition table for now.
-    this->ponderer_->Search(ponder_params, 300 * 100);
+  ponderer_->GetBoard()->MakeMove(ponder_move_);
+  ponder_result_ = Move();
+  transpos_dirty_ = true;
+  // The reply is searched with the user's settings, so that a ponder hit
+  // returns the move a regular search would have.
+  SearchParams ponder_params = search_params_;
+  ponder_params.thinking_output = false;
+  ponder_params.ponder = true;
+  pondering_thread_.reset(new std::thread([this, ponder_params] {
+    this->ponder_result_ = this->ponderer_->Search(ponder_params, 0, 0);
   }));
 }
 
@@ -180,6 +286,31 @@ void Executor::StopPondering() {
   pondering_thread_.reset(nullptr);
 }
 
+Move Executor::SearchMove(bool ponder_hit) {
+  const long allocated_centis = AllocateTime();
+  const long max_centis = MaxTime(allocated_centis);
+  if (ponder_hit) {
+    std::cout << "# Ponder hit: " << ponder_move_.str() << std::endl;
+    // The ponderer does not run proof-number search, so in that case its
+    // search only fills the transposition table for the player's search.
+    if (variant_ == Variant::SUICIDE && pns_) {
+      StopPondering();
+    } else {
+      ponderer_->PonderHit(allocated_centis, max_centis);
+      pondering_thread_->join();
+      pondering_thread_.reset(nullptr);
+      if (ponder_result_.is_valid()) {
+        ponder_move_ = ponderer_->PonderMove();
+        return ponder_result_;
+      }
+    }
+  }
+  const Move move =
+      player_->Search(search_params_, allocated_centis, max_centis);
+  ponder_move_ = player_->PonderMove();
+  return move;
+}
+
 void Executor::Execute(const string& command_str, vector<string>* response) {
   switch (Command command = Interpret(command_str); command.cmd_name) {
   case NEW: {
@@ -190,6 +321,7 @@ void Executor::Execute(const string& command_str, vector<string>* response) {
     book_ = true;
     think_time_centis_ = -1;
     search_params_.search_depth = MAX_DEPTH;
+    search_params_.max_nodes = 0;
     ReBuildPlayer(rand_moves_);
   } break;
 
@@ -211,6 +343,12 @@ void Executor::Execute(const string& command_str, vector<string>* response) {
               << std::endl;
   } break;
 
+  case NODES: {
+    std::stringstream ss(command.arguments.at(0));
+    ss >> search_params_.max_nodes;
+    std::cout << "# Node limit = " << search_params_.max_nodes << std::endl;
+  } break;
+
   case SETBOARD: {
     init_fen_.clear();
     for (const string& part : command.arguments) {
@@ -229,13 +367,37 @@ void Executor::Execute(const string& command_str, vector<string>* response) {
       break;
     }
     force_mode_ = false;
-    Move cmove = player_->Search(search_params_, AllocateTime());
+    Move cmove = SearchMove(false);
+    transpos_dirty_ = true;
     player_->GetBoard()->MakeMove(cmove);
     OutputFEN();
     response->push_back("move " + cmove.str());
     StartPondering(time_centis_);
   } break;
 
+  case CORES:
+    // The ponderer searches with the helpers that are rebuilt.
+    StopPondering();
+    num_threads_ = std::max(1, StringToInt(command.arguments.at(0)));
+    std::cout << "# Search threads = " << num_threads_ << std::endl;
+    if (player_) {
+      ReBuildHelpers();
+    }
+    break;
+
+  case MEMORY:
+    // The whole memory budget goes to the transposition table.
+    hash_megabytes_ = std::max(1, StringToInt(command.arguments.at(0)));
+    std::cout << "# Hash size = " << hash_megabytes_ << " MB" << std::endl;
+    break;
+
+  case SNAPSHOT:
+    // Takes effect when the next game starts.
+    snapshot_file_ = command.arguments.at(0);
+    std::cout << "# Transposition table snapshot = " << snapshot_file_
+              << std::endl;
+    break;
+
   case THINKTIME:
     think_time_centis_ = StringToInt(command.arguments.at(0));
     break;
@@ -249,8 +411,12 @@ void Executor::Execute(const string& command_str, vector<string>* response) {
     break;
 
   case USERMOVE: {
-    StopPondering();
     Move move(command.arguments.at(0));
+    const bool ponder_hit =
+        !force_mode_ && pondering_thread_ && move == ponder_move_;
+    if (!ponder_hit) {
+      StopPondering();
+    }
     if (force_mode_) {
       std::cout << "# Forced: " << player_->GetBoard()->ParseIntoFEN() << "|"
                 << move.str() << std::endl;
@@ -265,10 +431,12 @@ void Executor::Execute(const string& command_str, vector<string>* response) {
     player_->GetBoard()->MakeMove(move);
     OutputFEN();
     if (MatchResult(response)) {
+      StopPondering();
       break;
     }
 
-    Move cmove = player_->Search(search_params_, AllocateTime());
+    Move cmove = SearchMove(ponder_hit);
+    transpos_dirty_ = true;
     player_->GetBoard()->MakeMove(cmove);
     OutputFEN();
     response->push_back("move " + cmove.str());
@@ -382,6 +550,17 @@ long Executor::AllocateTime() const {
   return 5l;
 }
 
+// Returns the most time (in centis) the search may take when a move turns out
+// to be critical. A fixed time per move is never exceeded.
+long Executor::MaxTime(long allocated_centis) const {
+  if (think_time_centis_ > 0) {
+    return allocated_centis;
+  }
+  return std::max(allocated_centis,
+                  std::min(3 * allocated_centis,
+                           static_cast<long>(time_centis_ / 8)));
+}
+
 void Executor::OutputFEN() const {
   std::cout << "# FEN: " << player_->GetBoard()->ParseIntoFEN() << std::endl;
 }
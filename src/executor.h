@@ -11,6 +11,7 @@
 #include <vector>
 
 class Player;
+class EvalCache;
 class TranspositionTable;
 
 class Executor {
@@ -23,7 +24,10 @@ public:
         time_centis_(10 * 60 * 100), otime_centis_(10 * 60 * 100),
         init_fen_(init_fen) {}
 
-  ~Executor() { StopPondering(); }
+  ~Executor() {
+    StopPondering();
+    SaveSnapshot();
+  }
 
   // Executes command. Response may be set (depending on the command) in the
   // response string vector.
@@ -41,15 +45,31 @@ private:
 
   void ReBuildPlayer(int rand_moves);
   void ReBuildPonderer();
+  void ReBuildHelpers();
 
+  // Transposition table snapshots carry deep and solved entries over to later
+  // games and sessions. Snapshots are kept per variant, in files named after
+  // the 'snapshot' command argument followed by the variant.
+  void SaveSnapshot();
+  void LoadSnapshot();
+  std::string SnapshotFilename(Variant variant) const;
+
+  // The ponderer searches the position after the reply to our move that the
+  // search expects.
   void StartPondering(double time_centis);
   void StopPondering();
 
+  // Searches for our move. On a ponder hit, the ponder search is turned into
+  // the search for our move, unless the player runs proof-number search
+  // first.
+  Move SearchMove(bool ponder_hit);
+
   void MakeRandomMove(std::vector<std::string>* response);
 
   void OutputFEN() const;
 
   long AllocateTime() const;
+  long MaxTime(long allocated_centis) const;
 
   // Name of the computer player.
   std::string name_;
@@ -59,7 +79,12 @@ private:
   SearchParams search_params_;
   std::unique_ptr<PlayerBuilder> player_builder_;
   std::unique_ptr<PlayerBuilder> ponderer_builder_;
+  std::vector<std::unique_ptr<PlayerBuilder>> helper_builders_;
   std::unique_ptr<std::thread> pondering_thread_;
+  // Expected reply to our last move, and the move the ponderer found for us
+  // after that reply.
+  Move ponder_move_;
+  Move ponder_result_;
   Variant variant_;
   bool quit_ = false;
   bool force_mode_ = false;
@@ -69,6 +94,27 @@ private:
   int rand_moves_ = 0;
   int think_time_centis_ = -1;
 
+  // Number of search threads, i.e. the main search plus Lazy SMP helpers.
+  int num_threads_ = 1;
+
+  // Transposition table shared by the player, ponderer and helpers. It is
+  // cleared rather than reallocated when the player is rebuilt, and is
+  // resized on the next rebuild after the 'memory' command.
+  std::unique_ptr<TranspositionTable> transpos_;
+  int hash_megabytes_ = 256;
+  int transpos_megabytes_ = 0;
+
+  // Eval cache shared like the transposition table. Its size is fixed.
+  std::unique_ptr<EvalCache> eval_cache_;
+
+  // Variant of the positions in transpos_, and whether it was searched since
+  // it was last cleared or saved.
+  Variant transpos_variant_ = Variant::NORMAL;
+  bool transpos_dirty_ = false;
+
+  // Snapshots are disabled if empty.
+  std::string snapshot_file_;
+
   double time_centis_;
   double otime_centis_;
 
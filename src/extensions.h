@@ -5,7 +5,9 @@
 
 class LMR;
 class MoveOrderer;
+class NullMove;
 class PNSearch;
+class Quiescence;
 class Timer;
 
 struct PNSExtension {
@@ -17,6 +19,8 @@ struct PNSExtension {
 struct Extensions {
   std::unique_ptr<MoveOrderer> move_orderer;
   std::unique_ptr<LMR> lmr;
+  std::unique_ptr<Quiescence> quiescence;
+  std::unique_ptr<NullMove> null_move;
   PNSExtension pns_extension;
 };
 
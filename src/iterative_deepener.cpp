@@ -13,15 +13,35 @@
 #include "timer.h"
 #include "transpos.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <string>
 
+namespace {
+// Half width of the initial aspiration window around the previous iteration's
+// score.
+const int ASPIRATION_WINDOW = 50;
+} // namespace
+
 void IterativeDeepener::Search(const IDSParams& ids_params, Move* best_move,
                                int* best_move_score,
                                SearchStats* id_search_stats) {
   std::ostream& out = ids_params.thinking_output ? std::cout : nullstream;
   ClearState();
+  {
+    std::lock_guard<std::mutex> lock(time_manager_mutex_);
+    searching_ = true;
+    search_start_ = std::chrono::steady_clock::now();
+    if (ids_params.soft_time_centis > 0) {
+      time_manager_.SetLimits(ids_params.soft_time_centis,
+                              ids_params.hard_time_centis);
+    }
+  }
+  search_algorithm_->SetRoot();
+  if (extensions_->move_orderer) {
+    extensions_->move_orderer->NewSearch();
+  }
 
   StopWatch stop_watch;
   stop_watch.Start();
@@ -34,6 +54,7 @@ void IterativeDeepener::Search(const IDSParams& ids_params, Move* best_move,
   if (root_move_array_.size() == 0) {
     *best_move = Move();
     *best_move_score = INF;
+    EndTimeManagement();
     return;
   }
 
@@ -52,17 +73,19 @@ void IterativeDeepener::Search(const IDSParams& ids_params, Move* best_move,
   if (root_move_array_.size() == 1) {
     *best_move = root_move_array_.get(0);
     *best_move_score = INF;
+    EndTimeManagement();
     return;
   }
 
   // Iterative deepening starts here.
-  for (unsigned depth = 1; depth <= ids_params.search_depth; ++depth) {
+  for (unsigned depth = ids_params.start_depth;
+       depth <= ids_params.search_depth; ++depth) {
     // Do not use transposition table moves at the root if ordered/pruned
     // movelist is passed by the caller as we expect input ordering to be of
     // highest quality. Also, this avoids transposition table moves that are
     // not in the list to be brought to the front.
     if (ids_params.pruned_ordered_moves.size() == 0) {
-      if (auto* tentry = transpos_->Get(board_->ZobristKey());
+      if (auto tentry = transpos_->Get(board_->ZobristKey());
           tentry && tentry->best_move.is_valid()) {
         root_move_array_.PushToFront(tentry->best_move);
       }
@@ -95,10 +118,16 @@ void IterativeDeepener::Search(const IDSParams& ids_params, Move* best_move,
     // Update best_move and stats.
     *best_move = last_istat.best_move;
     *best_move_score = last_istat.score;
+    pv_ = last_istat.pv;
     id_search_stats->nodes_searched += last_istat.search_stats.nodes_searched;
     id_search_stats->nodes_researched +=
         last_istat.search_stats.nodes_researched;
     id_search_stats->nodes_evaluated += last_istat.search_stats.nodes_evaluated;
+    id_search_stats->aspiration_researches +=
+        last_istat.search_stats.aspiration_researches;
+    id_search_stats->transpos_hits += last_istat.search_stats.transpos_hits;
+    id_search_stats->transpos_misses +=
+        last_istat.search_stats.transpos_misses;
     id_search_stats->search_depth = last_istat.depth;
 
     // XBoard style thinking output.
@@ -106,7 +135,7 @@ void IterativeDeepener::Search(const IDSParams& ids_params, Move* best_move,
       char output[256];
       snprintf(output, 256, "%2d\t%5d\t%5d\t%10d\t%s", depth, last_istat.score,
                int(elapsed_time), id_search_stats->nodes_evaluated,
-               PV(*best_move).c_str());
+               PV(pv_).c_str());
       std::cout << output << std::endl;
     }
 
@@ -114,26 +143,109 @@ void IterativeDeepener::Search(const IDSParams& ids_params, Move* best_move,
     if (last_istat.score == WIN || timer_->Lapsed()) {
       break;
     }
+    if (std::lock_guard<std::mutex> lock(time_manager_mutex_);
+        time_manager_.IterationDone(last_istat.best_move, last_istat.score,
+                                    last_istat.best_move_nodes,
+                                    last_istat.search_stats.nodes_searched,
+                                    ElapsedCentis())) {
+      out << "# Time manager: stopping at depth " << depth << ", soft limit "
+          << time_manager_.ScaledSoftLimit() << " centis" << std::endl;
+      break;
+    }
   }
+  EndTimeManagement();
   stop_watch.Stop();
   out << "# Time taken for ID search: " << stop_watch.ElapsedTime() << " centis"
       << std::endl;
+  out << "# Re-searches: " << id_search_stats->nodes_researched
+      << " (null window), " << id_search_stats->aspiration_researches
+      << " (aspiration window)" << std::endl;
 }
 
 // Finds the best move by searching up to given max_depth. Stops and returns
 // quickly if timer expires during computation. Updates iteration_stats_ with
 // details of current iteration.
+//
+// The search is wrapped in an aspiration window centred on the score of the
+// previous iteration. If the score falls outside the window, the window is
+// widened on the failing side and the iteration is searched again.
 void IterativeDeepener::FindBestMove(int max_depth) {
   IterationStat istat;
   istat.depth = max_depth;
-  istat.best_move = root_move_array_.get(0);
-  istat.score = -INF;
-  istat.root_moves_covered = 0;
+
+  int window = ASPIRATION_WINDOW;
+  int alpha = -INF;
+  int beta = INF;
+  if (!iteration_stats_.empty() &&
+      iteration_stats_.back().root_moves_covered > 0) {
+    const int prev_score = iteration_stats_.back().score;
+    if (prev_score > -WIN && prev_score < WIN) {
+      alpha = std::max(prev_score - window, -INF);
+      beta = std::min(prev_score + window, INF);
+    }
+  }
+  while (true) {
+    SearchRoot(max_depth, alpha, beta, &istat);
+    if (timer_->Lapsed() && max_depth > 1) {
+      break;
+    }
+    if (istat.score <= alpha && alpha > -INF) {
+      window *= 2;
+      alpha = std::max(istat.score - window, -INF);
+    } else if (istat.score >= beta && beta < INF) {
+      window *= 2;
+      beta = std::min(istat.score + window, INF);
+    } else {
+      break;
+    }
+    ++istat.search_stats.aspiration_researches;
+  }
+
+  // Add move to transposition table if at least the first root move was
+  // completely searched to current depth before timer lapsed. Otherwise, we
+  // don't really have any valid move to update. Due to move ordering
+  // guarantees, the first move in root_move_array_ is guaranteed to be the
+  // best known move before current iteration, which means any other move found
+  // to be better at this depth is at least better than that. Scores outside
+  // the aspiration window are only bounds.
+  if (istat.root_moves_covered > 0) {
+    NodeType node_type = EXACT_NODE;
+    if (istat.score <= alpha && alpha > -INF) {
+      node_type = FAIL_LOW_NODE;
+    } else if (istat.score >= beta && beta < INF) {
+      node_type = FAIL_HIGH_NODE;
+    }
+    transpos_->Put(istat.score, node_type, max_depth, board_->ZobristKey(),
+                   istat.best_move);
+  }
+  iteration_stats_.push_back(istat);
+}
+
+// Searches the root moves with principal variation search in the given
+// window: the first move with the full window and the rest with a null window
+// around the best score so far, re-searching those that fail high.
+void IterativeDeepener::SearchRoot(int max_depth, int alpha, int beta,
+                                   IterationStat* istat) {
+  istat->best_move = root_move_array_.get(0);
+  istat->score = -INF;
+  istat->root_moves_covered = 0;
   for (unsigned int i = 0; i < root_move_array_.size(); ++i) {
     const Move& move = root_move_array_.get(i);
+    const unsigned nodes_before = istat->search_stats.nodes_searched;
     board_->MakeMove(move);
-    int score = -search_algorithm_->NegaScout(max_depth - 1, -INF, INF,
-                                              &istat.search_stats);
+    int score;
+    if (i == 0) {
+      score = -search_algorithm_->NegaScout(max_depth - 1, -beta, -alpha,
+                                            &istat->search_stats);
+    } else {
+      score = -search_algorithm_->NegaScout(max_depth - 1, -alpha - 1, -alpha,
+                                            &istat->search_stats);
+      if (score > alpha && score < beta) {
+        ++istat->search_stats.nodes_researched;
+        score = -search_algorithm_->NegaScout(max_depth - 1, -beta, -alpha,
+                                              &istat->search_stats);
+      }
+    }
     board_->UnmakeLastMove();
 
     // Return on timer expiry only if we are not searching at depth 1. If
@@ -145,55 +257,61 @@ void IterativeDeepener::FindBestMove(int max_depth) {
     if (timer_->Lapsed() && max_depth > 1) {
       break;
     }
-    if (score > istat.score) {
-      istat.best_move = move;
-      istat.score = score;
+    if (score > istat->score) {
+      istat->best_move = move;
+      istat->score = score;
+      istat->best_move_nodes =
+          istat->search_stats.nodes_searched - nodes_before;
+      istat->pv.clear();
+      istat->pv.Add(move);
+      search_algorithm_->AppendPrincipalVariation(1, &istat->pv);
+    }
+    ++istat->root_moves_covered;
+    if (score > alpha) {
+      alpha = score;
+      if (alpha >= beta) {
+        break;
+      }
     }
-    ++istat.root_moves_covered;
   }
-  // Add move to transposition table if at least the first root move was
-  // completely searched to current depth before timer lapsed. Otherwise, we
-  // don't really have any valid move to update. Due to move ordering
-  // guarantees, the first move in root_move_array_ is guaranteed to be the
-  // best known move before current iteration, which means any other move found
-  // to be better at this depth is at least better than that.
-  if (istat.root_moves_covered > 0) {
-    transpos_->Put(istat.score, EXACT_NODE, max_depth, board_->ZobristKey(),
-                   istat.best_move);
+}
+
+void IterativeDeepener::SetTimeLimits(double soft_time_centis,
+                                      double hard_time_centis) {
+  std::lock_guard<std::mutex> lock(time_manager_mutex_);
+  const double elapsed = searching_ ? ElapsedCentis() : 0.0;
+  time_manager_.SetLimits(soft_time_centis, elapsed + hard_time_centis);
+  if (searching_ && time_manager_.OutOfTime(elapsed)) {
+    timer_->Expire();
   }
-  iteration_stats_.push_back(istat);
+}
+
+void IterativeDeepener::EndTimeManagement() {
+  std::lock_guard<std::mutex> lock(time_manager_mutex_);
+  searching_ = false;
+  time_manager_ = TimeManager();
+}
+
+double IterativeDeepener::ElapsedCentis() const {
+  return std::chrono::duration<double, std::centi>(
+             std::chrono::steady_clock::now() - search_start_)
+      .count();
 }
 
 void IterativeDeepener::ClearState() {
   root_move_array_.clear();
   iteration_stats_.clear();
+  pv_.clear();
 }
 
-std::string IterativeDeepener::PV(const Move& root_move) {
-  std::string pv;
-
-  // Root move may not always be in the transposition table or the one in
-  // transposition table may not be the first move of PV if move ordering
-  // is determined externally.
-  pv.append(SAN(*board_, root_move) + " ");
-  board_->MakeMove(root_move);
-
-  int depth = 0;
-  while (depth < 10) {
-    U64 zkey = board_->ZobristKey();
-    TranspositionTableEntry* tentry = transpos_->Get(zkey);
-    if (!tentry || !tentry->best_move.is_valid() ||
-        tentry->node_type != EXACT_NODE) {
-      break;
-    }
-    pv.append(SAN(*board_, tentry->best_move) + " ");
-    ++depth;
-    board_->MakeMove(tentry->best_move);
+std::string IterativeDeepener::PV(const MoveArray& pv) {
+  std::string pv_str;
+  for (size_t i = 0; i < pv.size(); ++i) {
+    pv_str.append(SAN(*board_, pv.get(i)) + " ");
+    board_->MakeMove(pv.get(i));
   }
-  while (depth--) {
+  for (size_t i = 0; i < pv.size(); ++i) {
     board_->UnmakeLastMove();
   }
-
-  board_->UnmakeLastMove(); // root move
-  return pv;
+  return pv_str;
 }
@@ -4,7 +4,10 @@
 #include "move.h"
 #include "move_array.h"
 #include "stats.h"
+#include "time_manager.h"
 
+#include <chrono>
+#include <mutex>
 #include <vector>
 
 class Board;
@@ -18,7 +21,15 @@ class TranspositionTable;
 struct IDSParams {
   bool thinking_output = false;
   unsigned search_depth = MAX_DEPTH;
+  // Depth of the first iteration. Lazy SMP helpers start deeper than the main
+  // search so that the threads don't all work on the same depth.
+  unsigned start_depth = 1;
   MoveArray pruned_ordered_moves;
+  // If positive, a TimeManager decides after every iteration whether to go
+  // deeper, spending more or less than soft_time_centis but never more than
+  // hard_time_centis. Otherwise the search goes on until the timer lapses.
+  double soft_time_centis = 0;
+  double hard_time_centis = 0;
 };
 
 class IterativeDeepener {
@@ -32,11 +43,28 @@ public:
   void Search(const IDSParams& ids_params, Move* best_move,
               int* best_move_score, SearchStats* id_search_stats);
 
+  // Principal variation of the last search, starting with the best move. May
+  // be empty, e.g. if there was only one move to make.
+  const MoveArray& PrincipalVariation() const { return pv_; }
+
+  // Sets the time limits of a search that was started without any, i.e. a
+  // ponder search that has become the real search. Time searched so far counts
+  // against the soft limit, so the search may stop right away. The hard limit
+  // counts from now. May be called from another thread, also shortly before
+  // the search starts.
+  void SetTimeLimits(double soft_time_centis, double hard_time_centis);
+
 private:
+  struct IterationStat;
+
   void FindBestMove(int max_depth);
 
+  // Searches all root moves to given depth within the (alpha, beta) window and
+  // records the outcome in istat.
+  void SearchRoot(int max_depth, int alpha, int beta, IterationStat* istat);
+
   // Returns principal variation as a string of moves.
-  std::string PV(const Move& root_move);
+  std::string PV(const MoveArray& pv);
 
   void ClearState();
 
@@ -54,7 +82,8 @@ private:
   // is stored in the corresponding IterationStat object and pushed in the
   // iteration_stats_ vector.
   struct IterationStat {
-    IterationStat() : depth(0), score(0), root_moves_covered(0) {}
+    IterationStat()
+        : depth(0), score(0), root_moves_covered(0), best_move_nodes(0U) {}
 
     // Depth of search for current iteration.
     int depth;
@@ -65,15 +94,36 @@ private:
     // Score for the best move.
     int score;
 
+    // Principal variation, starting with the best move.
+    MoveArray pv;
+
     // Number of root moves completely searched before timer
     // expired at current depth.
     int root_moves_covered;
 
+    // Nodes searched below the best move.
+    unsigned best_move_nodes;
+
     // Stats for searching to this depth.
     SearchStats search_stats;
   };
 
   std::vector<IterationStat> iteration_stats_;
+
+  MoveArray pv_;
+
+  // Forgets the time limits and history of the search that just ended.
+  void EndTimeManagement();
+
+  // Centiseconds since the search started.
+  double ElapsedCentis() const;
+
+  // Guards the time manager and the search start, which SetTimeLimits()
+  // accesses from other threads.
+  std::mutex time_manager_mutex_;
+  TimeManager time_manager_;
+  bool searching_ = false;
+  std::chrono::steady_clock::time_point search_start_;
 };
 
 #endif
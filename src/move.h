@@ -31,6 +31,10 @@ public:
     EncodeMove(from_index, to_index, promoted_piece);
   }
 
+  // Reconstructs a move from its encoding, see encoded_move().
+  explicit Move(const EncodedMove encoded_move)
+      : encoded_move_(encoded_move) {}
+
   Move(std::string m) {
     const int from_index = index(m.substr(0, 2));
     const int to_index = index(m.substr(2, 2));
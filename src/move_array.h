@@ -38,6 +38,12 @@ public:
     moves_[index] = move;
   }
 
+  void Swap(size_t i, size_t j) {
+    const Move move = moves_[i];
+    moves_[i] = moves_[j];
+    moves_[j] = move;
+  }
+
   bool Contains(const Move& move) const {
     for (size_t i = 0; i < n_; ++i) {
       if (moves_[i] == move)
@@ -4,8 +4,10 @@
 #include "move.h"
 #include "move_array.h"
 #include "movegen.h"
+#include "piece.h"
 
 #include <algorithm>
+#include <climits>
 #include <cstdio>
 #include <cstring>
 
@@ -67,3 +69,107 @@ void CapturesFirstOrderer::Order(MoveArray* move_array) {
   }
   assert(num_moves == move_array->size());
 }
+
+void HistoryOrderer::Order(MoveArray* move_array) {
+  if (UseBaseOrderer()) {
+    base_orderer_->Order(move_array);
+  }
+  const Move* killers = killers_[board_->Ply() % KILLER_PLIES];
+  struct ScoredMove {
+    Move move;
+    int score;
+  };
+  ScoredMove scored_moves[256];
+  const size_t num_moves = move_array->size();
+  for (size_t i = 0; i < num_moves; ++i) {
+    const Move& move = move_array->get(i);
+    int score;
+    if (IsCapture(move)) {
+      score = INT_MAX;
+    } else if (move == killers[0]) {
+      score = INT_MAX - 1;
+    } else if (move == killers[1]) {
+      score = INT_MAX - 2;
+    } else {
+      score = history(board_->PieceAt(move.from_index()), move.to_index());
+    }
+    scored_moves[i] = {move, score};
+  }
+  std::stable_sort(scored_moves, scored_moves + num_moves,
+                   [](const ScoredMove& a, const ScoredMove& b) {
+                     return a.score > b.score;
+                   });
+  move_array->clear();
+  for (size_t i = 0; i < num_moves; ++i) {
+    move_array->Add(scored_moves[i].move);
+  }
+}
+
+void HistoryOrderer::NewSearch() {
+  root_ply_ = board_->Ply();
+  for (auto& ply_killers : killers_) {
+    for (Move& killer : ply_killers) {
+      killer = Move();
+    }
+  }
+  for (auto& piece_history : history_) {
+    for (int& score : piece_history) {
+      score /= 2;
+    }
+  }
+}
+
+void HistoryOrderer::RecordCutoff(const Move& move, int depth) {
+  // Captures are ordered first anyway.
+  if (IsCapture(move)) {
+    return;
+  }
+  Move* killers = killers_[board_->Ply() % KILLER_PLIES];
+  if (killers[0] != move) {
+    killers[1] = killers[0];
+    killers[0] = move;
+  }
+  // Cutoffs close to the root save larger subtrees and count more. Scores
+  // are halved when they grow large so that they never reach the killer and
+  // capture scores.
+  int& score = history(board_->PieceAt(move.from_index()), move.to_index());
+  score += depth * depth;
+  if (score > HISTORY_LIMIT) {
+    for (auto& piece_history : history_) {
+      for (int& s : piece_history) {
+        s /= 2;
+      }
+    }
+  }
+}
+
+void HistoryOrderer::Killers(MoveArray* killers) const {
+  for (const Move& killer : killers_[board_->Ply() % KILLER_PLIES]) {
+    if (killer.is_valid()) {
+      killers->Add(killer);
+    }
+  }
+}
+
+bool HistoryOrderer::ScoreQuietMoves(const MoveArray& move_array,
+                                     int* scores) {
+  if (UseBaseOrderer()) {
+    return false;
+  }
+  for (size_t i = 0; i < move_array.size(); ++i) {
+    const Move& move = move_array.get(i);
+    scores[i] = history(board_->PieceAt(move.from_index()), move.to_index());
+  }
+  return true;
+}
+
+bool HistoryOrderer::UseBaseOrderer() const {
+  return base_orderer_ && board_->Ply() - root_ply_ < base_orderer_plies_;
+}
+
+bool HistoryOrderer::IsCapture(const Move& move) const {
+  // En passant captures land on an empty square.
+  return board_->PieceAt(move.to_index()) != NULLPIECE ||
+         (move.to_index() == board_->EnpassantTarget() &&
+          PieceType(board_->PieceAt(move.from_index())) == PAWN);
+}
@@ -5,6 +5,7 @@
 #include "move.h"
 #include "move_array.h"
 
+#include <memory>
 #include <vector>
 
 class Board;
@@ -16,6 +17,24 @@ public:
 
   virtual void Order(MoveArray* move_array) = 0;
 
+  // Called at the start of every search, with the board at the root.
+  virtual void NewSearch() {}
+
+  // Called when given move caused a beta cutoff at a node searched to given
+  // depth. The board is at the node the move was played from.
+  virtual void RecordCutoff(const Move& move, int depth) {}
+
+  // Adds the killer moves of the current ply to given array, most recent
+  // first. They were recorded at other nodes and may be illegal here.
+  virtual void Killers(MoveArray* killers) const {}
+
+  // Fills 'scores' with a score for each of the quiet moves in 'move_array';
+  // higher scores are searched first. Returns false if there is no cheap score
+  // per move, in which case the moves are ordered with Order() instead.
+  virtual bool ScoreQuietMoves(const MoveArray& move_array, int* scores) {
+    return false;
+  }
+
 protected:
   MoveOrderer() {}
 };
@@ -44,4 +63,62 @@ private:
   Board* board_;
 };
 
+// Orders moves using what the search has learnt so far: captures come first,
+// then the killer moves that caused cutoffs at the same ply, then the other
+// quiet moves by how often they caused cutoffs anywhere in the tree (history
+// heuristic). A static base orderer may be applied first in the top plies of
+// the tree, where it is cheap relative to the size of the subtrees; its order
+// is kept for captures and breaks ties between quiet moves.
+class HistoryOrderer : public MoveOrderer {
+public:
+  HistoryOrderer(Board* board, std::unique_ptr<MoveOrderer> base_orderer,
+                 int base_orderer_plies)
+      : board_(board), base_orderer_(std::move(base_orderer)),
+        base_orderer_plies_(base_orderer_plies) {}
+  ~HistoryOrderer() override {}
+
+  void Order(MoveArray* move_array) override;
+
+  // Forgets killer moves and halves the history scores so that recent
+  // cutoffs weigh more than older ones.
+  void NewSearch() override;
+
+  void RecordCutoff(const Move& move, int depth) override;
+
+  void Killers(MoveArray* killers) const override;
+
+  // Scores by history, except in the top plies where the base orderer is
+  // applied.
+  bool ScoreQuietMoves(const MoveArray& move_array, int* scores) override;
+
+private:
+  // Returns true if the base orderer is applied at the current ply.
+  bool UseBaseOrderer() const;
+
+  static constexpr int NUM_KILLERS = 2;
+  static constexpr int KILLER_PLIES = 128;
+  static constexpr int HISTORY_LIMIT = 1 << 20;
+
+  bool IsCapture(const Move& move) const;
+
+  int& history(const Piece piece, const int to_index) {
+    return history_[piece + PAWN][to_index];
+  }
+
+  Board* board_;
+  std::unique_ptr<MoveOrderer> base_orderer_;
+  const int base_orderer_plies_;
+
+  // Board ply at the root of the current search.
+  int root_ply_ = 0;
+
+  // Killer moves indexed by board ply (modulo KILLER_PLIES), most recent
+  // first.
+  Move killers_[KILLER_PLIES][NUM_KILLERS];
+
+  // Cutoff scores indexed by moving piece (offset so that black pieces have
+  // non-negative indices) and destination square.
+  int history_[2 * PAWN + 1][BOARD_SIZE] = {};
+};
+
 #endif
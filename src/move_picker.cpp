@@ -0,0 +1,105 @@
+#include "move_picker.h"
+#include "move.h"
+#include "move_array.h"
+#include "move_order.h"
+#include "movegen.h"
+
+#include <utility>
+
+Move MovePicker::NextMove() {
+  switch (stage_) {
+  case TT_MOVE:
+    stage_ = GENERATE_CAPTURES;
+    // The move may come from another position with the same zobrist key.
+    if (tt_move_.is_valid() && movegen_->IsValidMove(tt_move_)) {
+      tt_move_yielded_ = true;
+      return tt_move_;
+    }
+    [[fallthrough]];
+
+  case GENERATE_CAPTURES:
+    movegen_->GenerateCaptures(&captures_);
+    if (orderer_) {
+      orderer_->Order(&captures_);
+    }
+    stage_ = CAPTURES;
+    [[fallthrough]];
+
+  case CAPTURES:
+    while (captures_index_ < captures_.size()) {
+      const Move move = captures_.get(captures_index_++);
+      if (!Yielded(move)) {
+        return move;
+      }
+    }
+    stage_ = GENERATE_KILLERS;
+    [[fallthrough]];
+
+  case GENERATE_KILLERS:
+    if (orderer_) {
+      orderer_->Killers(&killers_);
+    }
+    stage_ = KILLERS;
+    [[fallthrough]];
+
+  case KILLERS:
+    while (killers_index_ < killers_.size()) {
+      // Killers were recorded at other nodes and need not be legal here. A
+      // killer that captures in this position was yielded with the captures.
+      const Move move = killers_.get(killers_index_++);
+      if (!Yielded(move) && !captures_.Contains(move) &&
+          movegen_->IsValidMove(move)) {
+        yielded_killers_.Add(move);
+        return move;
+      }
+    }
+    stage_ = GENERATE_QUIETS;
+    [[fallthrough]];
+
+  case GENERATE_QUIETS:
+    movegen_->GenerateQuiets(&quiets_);
+    if (orderer_) {
+      pick_best_quiet_ = orderer_->ScoreQuietMoves(quiets_, quiet_scores_);
+      if (!pick_best_quiet_) {
+        orderer_->Order(&quiets_);
+      }
+    }
+    stage_ = QUIETS;
+    [[fallthrough]];
+
+  case QUIETS:
+    while (quiets_index_ < quiets_.size()) {
+      if (pick_best_quiet_) {
+        PickBestQuiet();
+      }
+      const Move move = quiets_.get(quiets_index_++);
+      if (!Yielded(move)) {
+        return move;
+      }
+    }
+    stage_ = DONE;
+    [[fallthrough]];
+
+  case DONE:
+    break;
+  }
+  return Move();
+}
+
+bool MovePicker::Yielded(const Move& move) const {
+  return (tt_move_yielded_ && move == tt_move_) ||
+         yielded_killers_.Contains(move);
+}
+
+void MovePicker::PickBestQuiet() {
+  size_t best = quiets_index_;
+  for (size_t i = quiets_index_ + 1; i < quiets_.size(); ++i) {
+    if (quiet_scores_[i] > quiet_scores_[best]) {
+      best = i;
+    }
+  }
+  if (best != quiets_index_) {
+    quiets_.Swap(quiets_index_, best);
+    std::swap(quiet_scores_[quiets_index_], quiet_scores_[best]);
+  }
+}
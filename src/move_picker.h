@@ -0,0 +1,67 @@
+#ifndef MOVE_PICKER_H
+#define MOVE_PICKER_H
+
+#include "move.h"
+#include "move_array.h"
+
+class MoveGenerator;
+class MoveOrderer;
+
+// Yields the moves of a node one at a time, in stages: the transposition
+// table move, captures, killer moves and then the remaining quiet moves. A
+// stage is generated only when the previous one is exhausted, so a node that
+// is cut off by an early move does not pay for generating and ordering the
+// rest. Moves are never yielded twice.
+class MovePicker {
+public:
+  // 'orderer' may be null, in which case moves within a stage are yielded in
+  // generation order. 'tt_move' may be invalid or illegal in this position.
+  MovePicker(MoveGenerator* movegen, MoveOrderer* orderer, const Move& tt_move)
+      : movegen_(movegen), orderer_(orderer), tt_move_(tt_move) {}
+
+  // Returns the next move to search, or an invalid move when all moves have
+  // been yielded.
+  Move NextMove();
+
+private:
+  enum Stage {
+    TT_MOVE,
+    GENERATE_CAPTURES,
+    CAPTURES,
+    GENERATE_KILLERS,
+    KILLERS,
+    GENERATE_QUIETS,
+    QUIETS,
+    DONE
+  };
+
+  // Returns true if the move was already yielded in an earlier stage.
+  bool Yielded(const Move& move) const;
+
+  // Moves the highest scored of the remaining quiet moves to quiets_index_.
+  void PickBestQuiet();
+
+  MoveGenerator* movegen_;
+  MoveOrderer* orderer_;
+  const Move tt_move_;
+  bool tt_move_yielded_ = false;
+
+  Stage stage_ = TT_MOVE;
+
+  MoveArray captures_;
+  size_t captures_index_ = 0;
+
+  MoveArray killers_;
+  size_t killers_index_ = 0;
+  MoveArray yielded_killers_;
+
+  MoveArray quiets_;
+  size_t quiets_index_ = 0;
+
+  // Scores of quiets_ when the orderer can score moves individually. Quiet
+  // moves are then picked best first instead of being sorted upfront.
+  int quiet_scores_[256];
+  bool pick_best_quiet_ = false;
+};
+
+#endif
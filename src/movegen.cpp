@@ -8,6 +8,7 @@
 
 #include <array>
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include <utility>
@@ -30,6 +31,9 @@ U64 AllAttacks(const Piece piece, const Board& board) {
   return attack_map;
 }
 
+// Subsets of moves that can be generated.
+enum MoveSubset { ALL_MOVES, CAPTURES_ONLY, QUIETS_ONLY };
+
 enum PawnMoveType {
   NW_CAPTURE = 9,
   NE_CAPTURE = 7,
@@ -94,25 +98,29 @@ U64 EnpassantBitBoard(const Board& board) {
 }
 
 template <Variant variant, Side side, typename MoveAccumulatorType>
-void GeneratePawnMoves(const Board& board, const bool generate_captures_only,
+void GeneratePawnMoves(const Board& board, const MoveSubset move_subset,
                        MoveAccumulatorType move_acc) {
-  const U64 opp_bitboard = board.BitBoard(OppositeSide(side));
-  const U64 pawn_capturable = opp_bitboard | EnpassantBitBoard<side>(board);
-
   const U64 pawn_bitboard = board.BitBoard(PieceOfSide(PAWN, side));
-  if (const U64 nw_captured =
-          side_relative::PushNorthWest<side>(pawn_bitboard) & pawn_capturable;
-      nw_captured) {
-    AddPawnMoves<variant, side, NW_CAPTURE>(nw_captured, move_acc);
-  }
+  if (move_subset != QUIETS_ONLY) {
+    const U64 opp_bitboard = board.BitBoard(OppositeSide(side));
+    const U64 pawn_capturable = opp_bitboard | EnpassantBitBoard<side>(board);
+
+    if (const U64 nw_captured =
+            side_relative::PushNorthWest<side>(pawn_bitboard) &
+            pawn_capturable;
+        nw_captured) {
+      AddPawnMoves<variant, side, NW_CAPTURE>(nw_captured, move_acc);
+    }
 
-  if (const U64 ne_captured =
-          side_relative::PushNorthEast<side>(pawn_bitboard) & pawn_capturable;
-      ne_captured) {
-    AddPawnMoves<variant, side, NE_CAPTURE>(ne_captured, move_acc);
+    if (const U64 ne_captured =
+            side_relative::PushNorthEast<side>(pawn_bitboard) &
+            pawn_capturable;
+        ne_captured) {
+      AddPawnMoves<variant, side, NE_CAPTURE>(ne_captured, move_acc);
+    }
   }
 
-  if (generate_captures_only) {
+  if (move_subset == CAPTURES_ONLY) {
     return;
   }
 
@@ -126,6 +134,29 @@ void GeneratePawnMoves(const Board& board, const bool generate_captures_only,
   AddPawnMoves<variant, side, TWO_STEP>(two_step, move_acc);
 }
 
+// Counts the pawn captures and the quiet pawn moves of 'side' in suicide.
+template <Side side>
+void CountPawnMoves_Suicide(const Board& board, int* num_captures,
+                            int* num_quiets) {
+  const U64 pawn_bitboard = board.BitBoard(PieceOfSide(PAWN, side));
+  const U64 pawn_capturable =
+      board.BitBoard(OppositeSide(side)) | EnpassantBitBoard<side>(board);
+  AddPawnMoves<Variant::SUICIDE, side, NW_CAPTURE>(
+      side_relative::PushNorthWest<side>(pawn_bitboard) & pawn_capturable,
+      num_captures);
+  AddPawnMoves<Variant::SUICIDE, side, NE_CAPTURE>(
+      side_relative::PushNorthEast<side>(pawn_bitboard) & pawn_capturable,
+      num_captures);
+
+  const U64 empty_bitboard = ~board.BitBoard();
+  const U64 one_step =
+      side_relative::PushFront<side>(pawn_bitboard) & empty_bitboard;
+  const U64 two_step = side_relative::PushFront<side>(one_step) &
+                       empty_bitboard & side_relative::MaskRow<side>(3);
+  AddPawnMoves<Variant::SUICIDE, side, ONE_STEP>(one_step, num_quiets);
+  AddPawnMoves<Variant::SUICIDE, side, TWO_STEP>(two_step, num_quiets);
+}
+
 template <Side side>
 U64 PawnCaptures(const U64 pawn_bitboard, const U64 pawn_capturable_bitboard) {
   return pawn_capturable_bitboard &
@@ -133,6 +164,79 @@ U64 PawnCaptures(const U64 pawn_bitboard, const U64 pawn_capturable_bitboard) {
           side_relative::PushNorthEast<side>(pawn_bitboard));
 }
 
+// A piece on the square at 'index' attacks the pieces that would attack it
+// from there, if they were of the other side.
+template <Side side>
+U64 AttackersTo(const Board& board, const int index) {
+  const U64 occupancy_bitboard = board.BitBoard();
+  auto pieces = [&board](const Piece piece_type) -> U64 {
+    return board.BitBoard(PieceOfSide(piece_type, side));
+  };
+  const U64 queens = pieces(QUEEN);
+  return PawnCaptures<OppositeSide(side)>(1ULL << index, pieces(PAWN)) |
+         (attacks::Attacks(occupancy_bitboard, index, KNIGHT) &
+          pieces(KNIGHT)) |
+         (attacks::Attacks(occupancy_bitboard, index, KING) & pieces(KING)) |
+         (attacks::Attacks(occupancy_bitboard, index, BISHOP) &
+          (pieces(BISHOP) | queens)) |
+         (attacks::Attacks(occupancy_bitboard, index, ROOK) &
+          (pieces(ROOK) | queens));
+}
+
+// Returns true if the king of 'side' is attacked.
+template <Side side>
+bool KingAttacked(const Board& board) {
+  const U64 king_bitboard = board.BitBoard(PieceOfSide(KING, side));
+  return king_bitboard &&
+         AttackersTo<OppositeSide(side)>(board, Lsb1(king_bitboard));
+}
+
+template <Side side>
+bool GivesCheck(Board* board, const Move& move) {
+  constexpr Side opp_side = OppositeSide(side);
+
+  const int from_index = move.from_index();
+  const int to_index = move.to_index();
+  const Piece piece = board->PieceAt(from_index);
+
+  // Castling and en passant captures move a second piece.
+  if ((PieceType(piece) == KING && std::abs(to_index - from_index) == 2) ||
+      (PieceType(piece) == PAWN && to_index == board->EnpassantTarget())) {
+    board->MakeMove(move);
+    const bool gives_check = KingAttacked<opp_side>(*board);
+    board->UnmakeLastMove();
+    return gives_check;
+  }
+
+  const U64 king_bitboard = board->BitBoard(PieceOfSide(KING, opp_side));
+  if (!king_bitboard) {
+    return false;
+  }
+  const U64 from_bitboard = 1ULL << from_index;
+  const U64 to_bitboard = 1ULL << to_index;
+  const U64 occupancy_bitboard = (board->BitBoard() ^ from_bitboard) |
+                                 to_bitboard;
+
+  const Piece moved_piece = move.is_promotion() ? move.promoted_piece() : piece;
+  if (PieceType(moved_piece) == PAWN) {
+    if (PawnCaptures<side>(to_bitboard, king_bitboard)) {
+      return true;
+    }
+  } else if (attacks::Attacks(occupancy_bitboard, to_index, moved_piece) &
+             king_bitboard) {
+    return true;
+  }
+
+  // Sliders behind the moved piece.
+  const int king_index = Lsb1(king_bitboard);
+  const U64 queens = board->BitBoard(PieceOfSide(QUEEN, side));
+  const U64 bishops = board->BitBoard(PieceOfSide(BISHOP, side)) | queens;
+  const U64 rooks = board->BitBoard(PieceOfSide(ROOK, side)) | queens;
+  return ((attacks::Attacks(occupancy_bitboard, king_index, BISHOP) & bishops) |
+          (attacks::Attacks(occupancy_bitboard, king_index, ROOK) & rooks)) &
+         ~from_bitboard;
+}
+
 // Castling is ignored.
 template <Side side>
 U64 GenerateAttackBitBoard(const Board& board) {
@@ -171,9 +275,9 @@ void BitBoardToMoves(const int unused_index, U64 bitboard, int* move_count) {
 }
 
 // Assumes king is not in check.
-template <Side side>
+template <Side side, typename MoveAccumulatorType>
 void GenerateCastlingMoves(const Board& board, const U64 opp_attack_map,
-                           MoveArray* move_array) {
+                           MoveAccumulatorType move_acc) {
 
   constexpr int row = (side == Side::WHITE) ? 0 : 7;
   constexpr U64 mask_fg = SetBit(row, FILE_F) | SetBit(row, FILE_G);
@@ -191,13 +295,13 @@ void GenerateCastlingMoves(const Board& board, const U64 opp_attack_map,
 
   if (board.CanCastle(side, KING)) {
     if (!(board.BitBoard() & mask_fg) && !(restricted_squares & mask_fg)) {
-      move_array->Add(Move(INDX(row, FILE_E), INDX(row, FILE_G)));
+      BitBoardToMoves(INDX(row, FILE_E), SetBit(row, FILE_G), move_acc);
     }
   }
 
   if (board.CanCastle(side, QUEEN)) {
     if (!(mask_bcd & board.BitBoard()) && !(restricted_squares & mask_cd)) {
-      move_array->Add(Move(INDX(row, FILE_E), INDX(row, FILE_C)));
+      BitBoardToMoves(INDX(row, FILE_E), SetBit(row, FILE_C), move_acc);
     }
   }
 }
@@ -205,12 +309,12 @@ void GenerateCastlingMoves(const Board& board, const U64 opp_attack_map,
 // Does not generate castling for king.
 template <Variant variant, Side side, typename MoveAccumulatorType>
 void GeneratePieceMoves(const Board& board, const Piece piece,
-                        const bool generate_captures_only,
+                        const MoveSubset move_subset,
                         MoveAccumulatorType move_acc) {
   assert(PieceOfSide(piece, side) == piece);
 
   if (PieceType(piece) == PAWN) {
-    GeneratePawnMoves<variant, side>(board, generate_captures_only, move_acc);
+    GeneratePawnMoves<variant, side>(board, move_subset, move_acc);
     return;
   }
 
@@ -226,8 +330,10 @@ void GeneratePieceMoves(const Board& board, const Piece piece,
     const int lsb_index = Lsb1(piece_bitboard);
     U64 attack_map =
         attacks::Attacks(occupancy_bitboard, lsb_index, piece) & ~self_bitboard;
-    if (generate_captures_only) {
+    if (move_subset == CAPTURES_ONLY) {
       attack_map &= opp_bitboard;
+    } else if (move_subset == QUIETS_ONLY) {
+      attack_map &= ~opp_bitboard;
     }
     if (attack_map) {
       BitBoardToMoves(lsb_index, attack_map, move_acc);
@@ -254,11 +360,12 @@ bool Captures(const Board& board) {
 
 template <Side side, typename MoveAccumulatorType>
 void GenerateMoves_Suicide(const Board& board, MoveAccumulatorType move_acc) {
-  const bool generate_captures_only = Captures<side>(board);
+  const MoveSubset move_subset =
+      Captures<side>(board) ? CAPTURES_ONLY : ALL_MOVES;
 
   auto generate = [&](const Piece piece_type) {
     GeneratePieceMoves<Variant::SUICIDE, side>(
-        board, PieceOfSide(piece_type, side), generate_captures_only, move_acc);
+        board, PieceOfSide(piece_type, side), move_subset, move_acc);
   };
 
   generate(BISHOP);
@@ -269,82 +376,350 @@ void GenerateMoves_Suicide(const Board& board, MoveAccumulatorType move_acc) {
   generate(ROOK);
 }
 
+// Returns the squares strictly between two squares on a common rank, file or
+// diagonal, or 0 if the squares are not aligned.
+U64 Between(const int index1, const int index2) {
+  static const auto between_table = [] {
+    std::array<std::array<U64, 64>, 64> table{};
+    for (int i = 0; i < 64; ++i) {
+      for (int j = 0; j < 64; ++j) {
+        for (const Piece piece_type : {ROOK, BISHOP}) {
+          if (attacks::Attacks(0ULL, i, piece_type) & (1ULL << j)) {
+            table[i][j] = attacks::Attacks(1ULL << j, i, piece_type) &
+                          attacks::Attacks(1ULL << i, j, piece_type);
+          }
+        }
+      }
+    }
+    return table;
+  }();
+  return between_table[index1][index2];
+}
+
+// Squares attacked by 'side' when the board has given occupancy. Unlike
+// GenerateAttackBitBoard(), pawn pushes are left out and squares with pieces
+// of 'side' are included.
 template <Side side>
-void GenerateMoves_Normal(Board* board, MoveArray* move_array) {
-  MoveArray pseudo_legal_move_array;
+U64 AttackedSquares(const Board& board, const U64 occupancy_bitboard) {
+  const U64 pawn_bitboard = board.BitBoard(PieceOfSide(PAWN, side));
+  U64 attack_map = side_relative::PushNorthWest<side>(pawn_bitboard) |
+                   side_relative::PushNorthEast<side>(pawn_bitboard);
+  U64 piece_bitboard = board.BitBoard(side) & ~pawn_bitboard;
+  while (piece_bitboard) {
+    const int lsb_index = Lsb1(piece_bitboard);
+    attack_map |= attacks::Attacks(occupancy_bitboard, lsb_index,
+                                   board.PieceAt(lsb_index));
+    piece_bitboard ^= (1ULL << lsb_index);
+  }
+  return attack_map;
+}
 
-  auto generate = [&](const Piece piece_type) {
-    GeneratePieceMoves<Variant::NORMAL, side>(
-        *board, PieceOfSide(piece_type, side), false, &pseudo_legal_move_array);
-  };
+// What the king of the side to move allows the other pieces to do, computed
+// once per position.
+struct KingSafety {
+  int king_index;
 
-  generate(BISHOP);
-  generate(KING);
-  generate(KNIGHT);
-  generate(PAWN);
-  generate(QUEEN);
-  generate(ROOK);
+  // Opponent pieces giving check.
+  U64 checkers;
 
-  constexpr Piece king_piece = PieceOfSide(KING, side);
-  const int king_index = Lsb1(board->BitBoard(king_piece));
+  // Squares a piece other than the king must move to: everywhere when not in
+  // check, the checker and the squares in between when in check, and nowhere
+  // when in double check.
+  U64 check_mask;
 
-  assert(king_index >= 0);
+  // Squares attacked by the opponent, with sliders seeing through the king.
+  U64 king_danger;
 
-  // Attacks on current playing side.
-  const U64 opp_attack_map = GenerateAttackBitBoard<OppositeSide(side)>(*board);
+  // Pinned pieces, and for each of them, the squares between the king and the
+  // pinning piece including the latter. Only valid for pinned squares.
+  U64 pinned;
+  U64 pin_rays[64];
+};
 
-  // If king is under check, work on evading check.
-  if (opp_attack_map & board->BitBoard(king_piece)) {
-    for (size_t i = 0; i < pseudo_legal_move_array.size(); ++i) {
-      const Move& move = pseudo_legal_move_array.get(i);
+template <Side side>
+void ComputeKingSafety(const Board& board, KingSafety* king_safety) {
+  constexpr Side opp_side = OppositeSide(side);
 
-      board->MakeMove(move);
+  const U64 king_bitboard = board.BitBoard(PieceOfSide(KING, side));
+  const int king_index = Lsb1(king_bitboard);
+  const U64 occupancy_bitboard = board.BitBoard();
 
-      // New opponent attack map.
-      const U64 new_opp_attack_map =
-          GenerateAttackBitBoard<OppositeSide(side)>(*board);
+  king_safety->king_index = king_index;
+  king_safety->king_danger =
+      AttackedSquares<opp_side>(board, occupancy_bitboard ^ king_bitboard);
+  king_safety->checkers = AttackersTo<opp_side>(board, king_index);
+  if (!king_safety->checkers) {
+    king_safety->check_mask = ~0ULL;
+  } else if (OnlyOneBitSet(king_safety->checkers)) {
+    king_safety->check_mask =
+        king_safety->checkers |
+        Between(king_index, Lsb1(king_safety->checkers));
+  } else {
+    king_safety->check_mask = 0ULL;
+  }
 
-      // Include move if legal.
-      if (!(new_opp_attack_map & board->BitBoard(king_piece))) {
-        move_array->Add(move);
-      }
+  // Opponent sliders that would attack the king on an empty board pin the
+  // only piece of 'side' in between, if there is one.
+  const U64 opp_queens = board.BitBoard(PieceOfSide(QUEEN, opp_side));
+  U64 snipers =
+      (attacks::Attacks(0ULL, king_index, ROOK) &
+       (board.BitBoard(PieceOfSide(ROOK, opp_side)) | opp_queens)) |
+      (attacks::Attacks(0ULL, king_index, BISHOP) &
+       (board.BitBoard(PieceOfSide(BISHOP, opp_side)) | opp_queens));
+  king_safety->pinned = 0ULL;
+  while (snipers) {
+    const int sniper_index = Lsb1(snipers);
+    const U64 between = Between(king_index, sniper_index);
+    const U64 blockers = between & occupancy_bitboard;
+    if (OnlyOneBitSet(blockers) && (blockers & board.BitBoard(side))) {
+      king_safety->pinned |= blockers;
+      king_safety->pin_rays[Lsb1(blockers)] = between | (1ULL << sniper_index);
+    }
+    snipers ^= (1ULL << sniper_index);
+  }
+}
+
+// Returns true if the en passant capture by the pawn on 'from_index' leaves
+// the king safe. The capture removes two pawns from the king's rank at times,
+// so it is tried on the board.
+template <Side side>
+bool IsLegalEnpassant(Board* board, const int from_index) {
+  board->MakeMove(Move(from_index, board->EnpassantTarget()));
+  const bool legal = !KingAttacked<side>(*board);
+  board->UnmakeLastMove();
+  return legal;
+}
 
-      board->UnmakeLastMove();
+template <Side side, typename MoveAccumulatorType>
+void GenerateLegalPawnMoves(Board* board, const MoveSubset move_subset,
+                            const KingSafety& king_safety,
+                            MoveAccumulatorType move_acc) {
+  const U64 pawn_bitboard = board->BitBoard(PieceOfSide(PAWN, side));
+  const U64 pinned_pawns = pawn_bitboard & king_safety.pinned;
+
+  // Drops the targets that take pinned pawns off their pin rays. 'push' maps
+  // a pawn to its target in the direction of 'targets'.
+  auto keep_pins = [&king_safety, pinned_pawns](U64 targets, U64 (*push)(U64)) {
+    U64 pawns = pinned_pawns;
+    while (pawns) {
+      const int lsb_index = Lsb1(pawns);
+      targets &= ~push(1ULL << lsb_index) | king_safety.pin_rays[lsb_index];
+      pawns ^= (1ULL << lsb_index);
     }
-  } else {
-    if (board->CanCastle(side, KING) || board->CanCastle(side, QUEEN)) {
-      GenerateCastlingMoves<side>(*board, opp_attack_map, move_array);
+    return targets;
+  };
+
+  if (move_subset != QUIETS_ONLY) {
+    // En passant captures are checked separately, as the captured pawn is not
+    // on the target square.
+    const U64 ep_bitboard = EnpassantBitBoard<side>(*board);
+    const U64 pawn_capturable =
+        (board->BitBoard(OppositeSide(side)) & king_safety.check_mask) |
+        ep_bitboard;
+
+    U64 nw_captured =
+        keep_pins(side_relative::PushNorthWest<side>(pawn_bitboard) &
+                      pawn_capturable,
+                  side_relative::PushNorthWest<side>);
+    if ((nw_captured & ep_bitboard) &&
+        !IsLegalEnpassant<side>(
+            board, board->EnpassantTarget() +
+                       (side == Side::WHITE ? -NW_CAPTURE : NW_CAPTURE))) {
+      nw_captured ^= ep_bitboard;
+    }
+    if (nw_captured) {
+      AddPawnMoves<Variant::NORMAL, side, NW_CAPTURE>(nw_captured, move_acc);
     }
 
-    // Check if there are any pinned pieces. This is not an exact set of
-    // pins but always a superset.
-    const U64 potential_pins =
-        attacks::Attacks(board->BitBoard(king_piece), king_index, QUEEN) &
-        opp_attack_map & board->BitBoard(side);
+    U64 ne_captured =
+        keep_pins(side_relative::PushNorthEast<side>(pawn_bitboard) &
+                      pawn_capturable,
+                  side_relative::PushNorthEast<side>);
+    if ((ne_captured & ep_bitboard) &&
+        !IsLegalEnpassant<side>(
+            board, board->EnpassantTarget() +
+                       (side == Side::WHITE ? -NE_CAPTURE : NE_CAPTURE))) {
+      ne_captured ^= ep_bitboard;
+    }
+    if (ne_captured) {
+      AddPawnMoves<Variant::NORMAL, side, NE_CAPTURE>(ne_captured, move_acc);
+    }
+  }
 
-    for (size_t i = 0; i < pseudo_legal_move_array.size(); ++i) {
-      const Move& move = pseudo_legal_move_array.get(i);
+  if (move_subset == CAPTURES_ONLY) {
+    return;
+  }
 
-      // Add all non-king, non-pinned piece moves.
-      if (move.from_index() != king_index &&
-          !((1ULL << move.from_index()) & potential_pins)) {
-        move_array->Add(move);
-        continue;
-      }
+  const U64 empty_bitboard = ~board->BitBoard();
 
-      // For king moves and pinned pieces, make sure the moves are valid.
-      board->MakeMove(move);
+  const U64 one_step =
+      side_relative::PushFront<side>(pawn_bitboard) & empty_bitboard;
+  const U64 two_step = side_relative::PushFront<side>(one_step) &
+                       empty_bitboard & side_relative::MaskRow<side>(3);
+  AddPawnMoves<Variant::NORMAL, side, ONE_STEP>(
+      keep_pins(one_step & king_safety.check_mask,
+                side_relative::PushFront<side>),
+      move_acc);
+  AddPawnMoves<Variant::NORMAL, side, TWO_STEP>(
+      keep_pins(two_step & king_safety.check_mask,
+                [](U64 bitboard) {
+                  return side_relative::PushFront<side>(
+                      side_relative::PushFront<side>(bitboard));
+                }),
+      move_acc);
+}
 
-      const U64 new_opp_attack_map =
-          GenerateAttackBitBoard<OppositeSide(side)>(*board);
+// Generates legal moves directly: the king never moves into danger, and the
+// other pieces keep to the check mask and their pin rays.
+template <Side side, typename MoveAccumulatorType>
+void GenerateMoves_Normal(Board* board, const MoveSubset move_subset,
+                          MoveAccumulatorType move_acc) {
+  KingSafety king_safety;
+  ComputeKingSafety<side>(*board, &king_safety);
+
+  const U64 occupancy_bitboard = board->BitBoard();
+  const U64 opp_bitboard = board->BitBoard(OppositeSide(side));
+  U64 target_mask = ~board->BitBoard(side);
+  if (move_subset == CAPTURES_ONLY) {
+    target_mask &= opp_bitboard;
+  } else if (move_subset == QUIETS_ONLY) {
+    target_mask &= ~opp_bitboard;
+  }
 
-      if (!(new_opp_attack_map & board->BitBoard(king_piece))) {
-        move_array->Add(move);
+  if (!king_safety.checkers && move_subset != CAPTURES_ONLY &&
+      (board->CanCastle(side, KING) || board->CanCastle(side, QUEEN))) {
+    GenerateCastlingMoves<side>(*board, king_safety.king_danger, move_acc);
+  }
+
+  auto generate = [&](const Piece piece_type) {
+    if (piece_type == KING) {
+      const U64 attack_map =
+          attacks::Attacks(occupancy_bitboard, king_safety.king_index, KING) &
+          target_mask & ~king_safety.king_danger;
+      if (attack_map) {
+        BitBoardToMoves(king_safety.king_index, attack_map, move_acc);
+      }
+      return;
+    }
+    if (!king_safety.check_mask) {
+      return;
+    }
+    if (piece_type == PAWN) {
+      GenerateLegalPawnMoves<side>(board, move_subset, king_safety, move_acc);
+      return;
+    }
+    const Piece piece = PieceOfSide(piece_type, side);
+    U64 piece_bitboard = board->BitBoard(piece);
+    while (piece_bitboard) {
+      const int lsb_index = Lsb1(piece_bitboard);
+      U64 attack_map = attacks::Attacks(occupancy_bitboard, lsb_index, piece) &
+                       target_mask & king_safety.check_mask;
+      if (king_safety.pinned & (1ULL << lsb_index)) {
+        attack_map &= king_safety.pin_rays[lsb_index];
       }
+      if (attack_map) {
+        BitBoardToMoves(lsb_index, attack_map, move_acc);
+      }
+      piece_bitboard ^= (1ULL << lsb_index);
+    }
+  };
+
+  generate(BISHOP);
+  generate(KING);
+  generate(KNIGHT);
+  generate(PAWN);
+  generate(QUEEN);
+  generate(ROOK);
+}
+
+// Returns true if 'move' would be generated for a piece of 'side' before the
+// checks for king safety (and compulsory captures in suicide). Castling is
+// not considered.
+template <Variant variant, Side side>
+bool IsPseudoLegalMove(const Board& board, const Move& move) {
+  const int from_index = move.from_index();
+  const Piece piece = board.PieceAt(from_index);
+  const U64 to_bitboard = 1ULL << move.to_index();
+  if (piece == NULLPIECE || PieceSide(piece) != side ||
+      (board.BitBoard(side) & to_bitboard)) {
+    return false;
+  }
+
+  const Piece promoted_type = PieceType(move.promoted_piece());
+  if (PieceType(piece) != PAWN) {
+    return promoted_type == NULLPIECE &&
+           (attacks::Attacks(board.BitBoard(), from_index, piece) &
+            to_bitboard);
+  }
 
-      board->UnmakeLastMove();
+  if (to_bitboard & side_relative::MaskRow<side>(7)) {
+    if (promoted_type == NULLPIECE || promoted_type == PAWN ||
+        (promoted_type == KING && variant != Variant::SUICIDE)) {
+      return false;
     }
+  } else if (promoted_type != NULLPIECE) {
+    return false;
   }
+  const U64 pawn_bitboard = 1ULL << from_index;
+  const U64 empty_bitboard = ~board.BitBoard();
+  const U64 one_step =
+      side_relative::PushFront<side>(pawn_bitboard) & empty_bitboard;
+  const U64 two_step = side_relative::PushFront<side>(one_step) &
+                       empty_bitboard & side_relative::MaskRow<side>(3);
+  const U64 captures = PawnCaptures<side>(
+      pawn_bitboard,
+      board.BitBoard(OppositeSide(side)) | EnpassantBitBoard<side>(board));
+  return (one_step | two_step | captures) & to_bitboard;
+}
+
+template <Side side>
+bool IsValidMove_Suicide(const Board& board, const Move& move) {
+  if (!IsPseudoLegalMove<Variant::SUICIDE, side>(board, move)) {
+    return false;
+  }
+  // Captures are compulsory.
+  const bool is_capture =
+      (board.BitBoard(OppositeSide(side)) & (1ULL << move.to_index())) ||
+      (PieceType(board.PieceAt(move.from_index())) == PAWN &&
+       move.to_index() == board.EnpassantTarget());
+  return is_capture || !Captures<side>(board);
+}
+
+// Mirrors the legality checks of GenerateMoves_Normal() for a single move.
+template <Side side>
+bool IsValidMove_Normal(Board* board, const Move& move) {
+  KingSafety king_safety;
+  ComputeKingSafety<side>(*board, &king_safety);
+  const int king_index = king_safety.king_index;
+
+  if (move.from_index() == king_index &&
+      std::abs(move.to_index() - king_index) == 2) {
+    if (king_safety.checkers || move.is_promotion()) {
+      return false;
+    }
+    MoveArray castling_moves;
+    GenerateCastlingMoves<side>(*board, king_safety.king_danger,
+                                &castling_moves);
+    return castling_moves.Contains(move);
+  }
+
+  if (!IsPseudoLegalMove<Variant::NORMAL, side>(*board, move)) {
+    return false;
+  }
+
+  const U64 to_bitboard = 1ULL << move.to_index();
+  if (move.from_index() == king_index) {
+    return !(to_bitboard & king_safety.king_danger);
+  }
+  if (PieceType(board->PieceAt(move.from_index())) == PAWN &&
+      move.to_index() == board->EnpassantTarget()) {
+    return IsLegalEnpassant<side>(board, move.from_index());
+  }
+  if (king_safety.pinned & (1ULL << move.from_index())) {
+    return to_bitboard & king_safety.check_mask &
+           king_safety.pin_rays[move.from_index()];
+  }
+  return to_bitboard & king_safety.check_mask;
 }
 
 } // namespace
@@ -366,6 +741,45 @@ U64 ComputeAttackMap(const Board& board, const Side attacker_side) {
   return attack_map;
 }
 
+U64 AttackersTo(const Board& board, const int index, const Side attacker_side) {
+  switch (attacker_side) {
+  case Side::WHITE:
+    return AttackersTo<Side::WHITE>(board, index);
+
+  case Side::BLACK:
+    return AttackersTo<Side::BLACK>(board, index);
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
+}
+
+bool InCheck(const Board& board) {
+  switch (board.SideToMove()) {
+  case Side::WHITE:
+    return KingAttacked<Side::WHITE>(board);
+
+  case Side::BLACK:
+    return KingAttacked<Side::BLACK>(board);
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
+}
+
+bool GivesCheck(Board* board, const Move& move) {
+  switch (board->SideToMove()) {
+  case Side::WHITE:
+    return GivesCheck<Side::WHITE>(board, move);
+
+  case Side::BLACK:
+    return GivesCheck<Side::BLACK>(board, move);
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
+}
+
 void MoveGeneratorSuicide::GenerateMoves(MoveArray* move_array) {
   switch (board_.SideToMove()) {
   case Side::BLACK:
@@ -400,20 +814,133 @@ int MoveGeneratorSuicide::CountMoves() {
   return move_count;
 }
 
+SuicideMoveCounts MoveGeneratorSuicide::CountMovesBothSides() const {
+  int num_captures[2] = {0, 0};
+  int num_quiets[2] = {0, 0};
+  CountPawnMoves_Suicide<Side::WHITE>(board_, &num_captures[0],
+                                      &num_quiets[0]);
+  CountPawnMoves_Suicide<Side::BLACK>(board_, &num_captures[1],
+                                      &num_quiets[1]);
+
+  // The attack set of every other piece is computed once and split into the
+  // captures and quiet moves of its side.
+  const U64 occupancy_bitboard = board_.BitBoard();
+  const U64 side_bitboards[2] = {board_.BitBoard(Side::WHITE),
+                                 board_.BitBoard(Side::BLACK)};
+  U64 piece_bitboard =
+      occupancy_bitboard & ~board_.BitBoard(PieceOfSide(PAWN, Side::WHITE)) &
+      ~board_.BitBoard(PieceOfSide(PAWN, Side::BLACK));
+  while (piece_bitboard) {
+    const int index = Lsb1(piece_bitboard);
+    const Piece piece = board_.PieceAt(index);
+    const int side_index = SideIndex(PieceSide(piece));
+    const U64 attack_map = attacks::Attacks(occupancy_bitboard, index, piece);
+    num_captures[side_index] +=
+        PopCount(attack_map & side_bitboards[side_index ^ 1]);
+    num_quiets[side_index] += PopCount(attack_map & ~occupancy_bitboard);
+    piece_bitboard ^= (1ULL << index);
+  }
+
+  SuicideMoveCounts move_counts;
+  for (int i = 0; i < 2; ++i) {
+    move_counts.must_capture[i] = num_captures[i] > 0;
+    move_counts.num_moves[i] =
+        move_counts.must_capture[i] ? num_captures[i] : num_quiets[i];
+  }
+  return move_counts;
+}
+
+void MoveGeneratorSuicide::GenerateCaptures(MoveArray* move_array) {
+  // Captures are compulsory, so either all moves are captures or none are.
+  switch (board_.SideToMove()) {
+  case Side::BLACK:
+    if (Captures<Side::BLACK>(board_)) {
+      GenerateMoves_Suicide<Side::BLACK>(board_, move_array);
+    }
+    break;
+
+  case Side::WHITE:
+    if (Captures<Side::WHITE>(board_)) {
+      GenerateMoves_Suicide<Side::WHITE>(board_, move_array);
+    }
+    break;
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
+}
+
+void MoveGeneratorSuicide::GenerateQuiets(MoveArray* move_array) {
+  // Captures are compulsory, so either all moves are quiet or none are.
+  switch (board_.SideToMove()) {
+  case Side::BLACK:
+    if (!Captures<Side::BLACK>(board_)) {
+      GenerateMoves_Suicide<Side::BLACK>(board_, move_array);
+    }
+    break;
+
+  case Side::WHITE:
+    if (!Captures<Side::WHITE>(board_)) {
+      GenerateMoves_Suicide<Side::WHITE>(board_, move_array);
+    }
+    break;
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
+}
+
 bool MoveGeneratorSuicide::IsValidMove(const Move& move) {
-  MoveArray move_array;
-  GenerateMoves(&move_array);
-  return move_array.Contains(move);
+  switch (board_.SideToMove()) {
+  case Side::BLACK:
+    return IsValidMove_Suicide<Side::BLACK>(board_, move);
+
+  case Side::WHITE:
+    return IsValidMove_Suicide<Side::WHITE>(board_, move);
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
 }
 
 void MoveGeneratorNormal::GenerateMoves(MoveArray* move_array) {
   switch (board_->SideToMove()) {
   case Side::BLACK:
-    GenerateMoves_Normal<Side::BLACK>(board_, move_array);
+    GenerateMoves_Normal<Side::BLACK>(board_, ALL_MOVES, move_array);
     break;
 
   case Side::WHITE:
-    GenerateMoves_Normal<Side::WHITE>(board_, move_array);
+    GenerateMoves_Normal<Side::WHITE>(board_, ALL_MOVES, move_array);
+    break;
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
+}
+
+void MoveGeneratorNormal::GenerateCaptures(MoveArray* move_array) {
+  switch (board_->SideToMove()) {
+  case Side::BLACK:
+    GenerateMoves_Normal<Side::BLACK>(board_, CAPTURES_ONLY, move_array);
+    break;
+
+  case Side::WHITE:
+    GenerateMoves_Normal<Side::WHITE>(board_, CAPTURES_ONLY, move_array);
+    break;
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
+}
+
+void MoveGeneratorNormal::GenerateQuiets(MoveArray* move_array) {
+  switch (board_->SideToMove()) {
+  case Side::BLACK:
+    GenerateMoves_Normal<Side::BLACK>(board_, QUIETS_ONLY, move_array);
+    break;
+
+  case Side::WHITE:
+    GenerateMoves_Normal<Side::WHITE>(board_, QUIETS_ONLY, move_array);
     break;
 
   default:
@@ -422,13 +949,33 @@ void MoveGeneratorNormal::GenerateMoves(MoveArray* move_array) {
 }
 
 int MoveGeneratorNormal::CountMoves() {
-  MoveArray move_array;
-  GenerateMoves(&move_array);
-  return move_array.size();
+  int move_count = 0;
+
+  switch (board_->SideToMove()) {
+  case Side::BLACK:
+    GenerateMoves_Normal<Side::BLACK>(board_, ALL_MOVES, &move_count);
+    break;
+
+  case Side::WHITE:
+    GenerateMoves_Normal<Side::WHITE>(board_, ALL_MOVES, &move_count);
+    break;
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
+
+  return move_count;
 }
 
 bool MoveGeneratorNormal::IsValidMove(const Move& move) {
-  MoveArray move_array;
-  GenerateMoves(&move_array);
-  return move_array.Contains(move);
+  switch (board_->SideToMove()) {
+  case Side::BLACK:
+    return IsValidMove_Normal<Side::BLACK>(board_, move);
+
+  case Side::WHITE:
+    return IsValidMove_Normal<Side::WHITE>(board_, move);
+
+  default:
+    throw std::runtime_error("Unknown side");
+  }
 }
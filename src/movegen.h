@@ -13,8 +13,16 @@ public:
 
   virtual void GenerateMoves(MoveArray* move_array) = 0;
 
+  // Generates only the legal moves that capture a piece.
+  virtual void GenerateCaptures(MoveArray* move_array) = 0;
+
+  // Generates the legal moves that don't capture a piece.
+  virtual void GenerateQuiets(MoveArray* move_array) = 0;
+
   virtual int CountMoves() = 0;
 
+  // Returns true if given move is legal. Does not generate all the moves, so
+  // it is cheap enough to validate moves from the transposition table.
   virtual bool IsValidMove(const Move& move) = 0;
 
 protected:
@@ -28,6 +36,10 @@ public:
 
   void GenerateMoves(MoveArray* move_array) final;
 
+  void GenerateCaptures(MoveArray* move_array) final;
+
+  void GenerateQuiets(MoveArray* move_array) final;
+
   int CountMoves() final;
 
   bool IsValidMove(const Move& move) final;
@@ -36,6 +48,13 @@ private:
   Board* board_;
 };
 
+// Number of moves of each side in a suicide position, indexed by SideIndex().
+// A side that can capture must capture, so only its captures are counted.
+struct SuicideMoveCounts {
+  int num_moves[2];
+  bool must_capture[2];
+};
+
 // Move generator for suicide chess.
 class MoveGeneratorSuicide : public MoveGenerator {
 public:
@@ -43,8 +62,17 @@ public:
 
   void GenerateMoves(MoveArray* move_array) final;
 
+  void GenerateCaptures(MoveArray* move_array) final;
+
+  void GenerateQuiets(MoveArray* move_array) final;
+
   int CountMoves() final;
 
+  // Counts the moves of both sides in one pass over the pieces. The count of
+  // the side to move equals CountMoves(), and that of the other side equals
+  // CountMoves() after Board::FlipSideToMove().
+  SuicideMoveCounts CountMovesBothSides() const;
+
   bool IsValidMove(const Move& move) final;
 
 private:
@@ -54,4 +82,16 @@ private:
 // Computes all possible attacks on the board by the attacking side.
 U64 ComputeAttackMap(const Board& board, const Side attacker_side);
 
+// Returns the pieces of the attacking side that attack the square at 'index'.
+U64 AttackersTo(const Board& board, const int index, const Side attacker_side);
+
+// Returns true if the king of the side to move is attacked. Only meaningful
+// for normal chess.
+bool InCheck(const Board& board);
+
+// Returns true if the given legal move of the side to move attacks the
+// opponent's king, directly or by uncovering a slider. Only castling and en
+// passant captures are made on the board to find out.
+bool GivesCheck(Board* board, const Move& move);
+
 #endif
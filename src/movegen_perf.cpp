@@ -12,14 +12,14 @@
 #include <iostream>
 
 int64_t Perft(MoveGenerator* movegen, Board* board, unsigned int depth) {
-  MoveArray move_array;
-  movegen->GenerateMoves(&move_array);
-
   // Bulk counting at depth 1.
   if (depth == 1) {
-    return move_array.size();
+    return movegen->CountMoves();
   }
 
+  MoveArray move_array;
+  movegen->GenerateMoves(&move_array);
+
   int64_t nodes = 0;
   for (unsigned i = 0; i < move_array.size(); ++i) {
     board->MakeMove(move_array.get(i));
@@ -29,17 +29,20 @@ int64_t Perft(MoveGenerator* movegen, Board* board, unsigned int depth) {
   return nodes;
 }
 
+// Usage: movegen_perf <normal|suicide> <depth> [fen]
 int main(int argc, char** argv) {
-  assert(argc == 3);
+  assert(argc == 3 || argc == 4);
 
   unsigned int depth = 0;
   Board* board = NULL;
   MoveGenerator* movegen = NULL;
   if (argv[1][0] == 's' || argv[1][0] == 'S') {
-    board = new Board(Variant::SUICIDE);
+    board = argc == 4 ? new Board(Variant::SUICIDE, argv[3])
+                      : new Board(Variant::SUICIDE);
     movegen = new MoveGeneratorSuicide(*board);
   } else {
-    board = new Board(Variant::NORMAL);
+    board = argc == 4 ? new Board(Variant::NORMAL, argv[3])
+                      : new Board(Variant::NORMAL);
     movegen = new MoveGeneratorNormal(board);
   }
   depth = atoi(argv[2]);
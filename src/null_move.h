@@ -0,0 +1,38 @@
+#ifndef NULL_MOVE_H
+#define NULL_MOVE_H
+
+// Settings for null-move pruning in normal chess. If the side to move could
+// pass and a reduced depth search still fails high, a real move is very
+// likely to fail high as well and the node is pruned. This does not hold in
+// zugzwang, where every move makes things worse, so fail highs at deeper
+// nodes are verified by a reduced depth search of the real moves.
+class NullMove {
+public:
+  NullMove(const int reduction, const int min_depth,
+           const int verification_depth)
+      : reduction_(reduction), min_depth_(min_depth),
+        verification_depth_(verification_depth) {}
+
+  // Returns true if a null move may be tried at a node with given remaining
+  // search depth.
+  bool CanTry(const int search_depth_remaining) const {
+    return search_depth_remaining >= min_depth_;
+  }
+
+  // Number of plies the search after a null move is reduced by, in addition
+  // to the ply of the null move itself.
+  int Reduction() const { return reduction_; }
+
+  // Returns true if a fail high after the null move has to be confirmed by
+  // searching the real moves before the node is pruned.
+  bool NeedsVerification(const int search_depth_remaining) const {
+    return search_depth_remaining >= verification_depth_;
+  }
+
+private:
+  const int reduction_;
+  const int min_depth_;
+  const int verification_depth_;
+};
+
+#endif
@@ -10,23 +10,29 @@
 #include "pn_search.h"
 #include "stopwatch.h"
 #include "timer.h"
+#include "transpos.h"
 
 #include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <signal.h>
 #include <sys/time.h>
+#include <thread>
+#include <vector>
 
 Player::Player(const Book* book, Board* board, MoveGenerator* movegen,
-               IterativeDeepener* iterative_deepener, Timer* timer, EGTB* egtb,
+               IterativeDeepener* iterative_deepener, Timer* timer,
+               TranspositionTable* transpos, EGTB* egtb,
                Extensions* extensions, int rand_moves)
     : book_(book), board_(board), movegen_(movegen),
-      iterative_deepener_(iterative_deepener), timer_(timer), egtb_(egtb),
-      extensions_(extensions), rand_moves_(rand_moves) {}
+      iterative_deepener_(iterative_deepener), timer_(timer),
+      transpos_(transpos), egtb_(egtb), extensions_(extensions),
+      rand_moves_(rand_moves) {}
 
 Move Player::Search(const SearchParams& search_params,
-                    long time_for_move_centis) {
+                    long time_for_move_centis, long max_time_for_move_centis) {
   std::ostream& out = search_params.thinking_output ? std::cout : nullstream;
+  ponder_move_ = Move();
   if (rand_moves_ > 0) {
     MoveArray move_array;
     movegen_->GenerateMoves(&move_array);
@@ -57,12 +63,15 @@ Move Player::Search(const SearchParams& search_params,
     return move_array.get(0);
   }
 
+  // Entries left over from searches of earlier positions are replaced first.
+  transpos_->NewSearch();
+
   IDSParams ids_params;
   ids_params.thinking_output = search_params.thinking_output;
   ids_params.search_depth = search_params.search_depth;
 
   if (const auto& pns_extension = extensions_->pns_extension;
-      pns_extension.pn_search) {
+      pns_extension.pn_search && search_params.max_nodes == 0) {
     assert(pns_extension.pns_timer);
 
     pns_extension.pns_timer->Reset();
@@ -112,16 +121,99 @@ Move Player::Search(const SearchParams& search_params,
 
     // Subtract time taken by PNSearch.
     time_for_move_centis -= static_cast<long>(pn_stop_watch.ElapsedTime());
+    max_time_for_move_centis -= static_cast<long>(pn_stop_watch.ElapsedTime());
     out << "# Time left: " << time_for_move_centis << " centis" << std::endl;
   }
 
-  timer_->Reset();
-  timer_->Run(time_for_move_centis);
+  if (search_params.max_nodes > 0) {
+    timer_->Reset();
+    timer_->SetNodeLimit(search_params.max_nodes);
+  } else {
+    if (max_time_for_move_centis > time_for_move_centis) {
+      ids_params.soft_time_centis = time_for_move_centis;
+      ids_params.hard_time_centis = max_time_for_move_centis;
+    } else {
+      max_time_for_move_centis = time_for_move_centis;
+    }
+    // A ponderer's timer is left alone: it is new for every ponder search,
+    // and a ponder hit may already have set its deadline.
+    if (!search_params.ponder) {
+      timer_->Reset();
+      timer_->Run(max_time_for_move_centis);
+    }
+  }
+
+  // Lazy SMP: helpers search copies of the board and only communicate with us
+  // through the shared transposition table. Every other helper starts one ply
+  // deeper so that the threads spread over different depths. Node limited
+  // searches are not shared, as helpers make them nondeterministic.
+  const size_t num_helpers =
+      search_params.max_nodes > 0 ? 0U : helpers_.size();
+  std::vector<std::thread> helper_threads;
+  std::vector<SearchStats> helper_search_stats(num_helpers);
+  for (size_t i = 0; i < num_helpers; ++i) {
+    Player* helper = helpers_.at(i);
+    *helper->board_ = *board_;
+    helper->timer_->Reset();
+    IDSParams helper_ids_params = ids_params;
+    helper_ids_params.thinking_output = false;
+    helper_ids_params.start_depth = 1 + (i % 2 == 0);
+    SearchStats* helper_stats = &helper_search_stats.at(i);
+    helper_threads.emplace_back([helper, helper_ids_params, helper_stats] {
+      Move helper_move;
+      int helper_move_score;
+      helper->iterative_deepener_->Search(helper_ids_params, &helper_move,
+                                          &helper_move_score, helper_stats);
+    });
+  }
 
   SearchStats id_search_stats;
   int move_score;
   Move best_move;
   iterative_deepener_->Search(ids_params, &best_move, &move_score,
                               &id_search_stats);
+  if (const MoveArray& pv = iterative_deepener_->PrincipalVariation();
+      pv.size() >= 2 && pv.get(0) == best_move) {
+    ponder_move_ = pv.get(1);
+  }
+  if (const long latency = timer_->LatencyMicros(); latency >= 0) {
+    out << "# Timer latency: " << latency << " us" << std::endl;
+  }
+  if (search_params.max_nodes > 0) {
+    out << "# Nodes counted: " << timer_->NodesCounted() << std::endl;
+  }
+
+  // Helpers don't run a timer of their own; they search until we are done.
+  for (Player* helper : helpers_) {
+    helper->timer_->Expire();
+  }
+  for (std::thread& helper_thread : helper_threads) {
+    helper_thread.join();
+  }
+  unsigned transpos_hits = id_search_stats.transpos_hits;
+  unsigned transpos_misses = id_search_stats.transpos_misses;
+  for (const SearchStats& helper_stats : helper_search_stats) {
+    transpos_hits += helper_stats.transpos_hits;
+    transpos_misses += helper_stats.transpos_misses;
+  }
+  transpos_->AddStats(transpos_hits, transpos_misses);
+  if (num_helpers > 0) {
+    unsigned helper_nodes_searched = 0U;
+    for (const SearchStats& helper_stats : helper_search_stats) {
+      helper_nodes_searched += helper_stats.nodes_searched;
+    }
+    out << "# Threads: " << helpers_.size() + 1
+        << ", nodes searched: " << id_search_stats.nodes_searched << " (main), "
+        << helper_nodes_searched << " (helpers)" << std::endl;
+  }
   return best_move;
 }
+
+void Player::PonderHit(long time_for_move_centis,
+                       long max_time_for_move_centis) {
+  timer_->Run(max_time_for_move_centis);
+  if (max_time_for_move_centis > time_for_move_centis) {
+    iterative_deepener_->SetTimeLimits(time_for_move_centis,
+                                       max_time_for_move_centis);
+  }
+}
@@ -9,36 +9,69 @@
 
 #include <signal.h>
 #include <sys/time.h>
+#include <vector>
 
 class EGTB;
 class IterativeDeepener;
 class MoveGenerator;
+class TranspositionTable;
 struct Extensions;
 
 struct SearchParams {
   bool thinking_output = false;
   int search_depth = MAX_DEPTH;
+  // Ponder searches have no deadline. They go on until PonderHit() sets one
+  // or the timer is invalidated.
+  bool ponder = false;
+  // If positive, the search stops after this many nodes instead of on time.
+  // Such searches run on one thread without proof-number search, so their
+  // results only depend on the position and the transposition table.
+  unsigned long max_nodes = 0;
 };
 
 class Player {
 public:
   Player(const Book* book, Board* board, MoveGenerator* movegen,
-         IterativeDeepener* iterative_deepener, Timer* timer, EGTB* egtb,
-         Extensions* extensions, int rand_moves);
+         IterativeDeepener* iterative_deepener, Timer* timer,
+         TranspositionTable* transpos, EGTB* egtb, Extensions* extensions,
+         int rand_moves);
 
-  Move Search(const SearchParams& search_params, long time_for_move_centis);
+  // Searches for about time_for_move_centis. If max_time_for_move_centis is
+  // larger, the search may stop earlier in easy positions and take up to that
+  // long in critical ones.
+  Move Search(const SearchParams& search_params, long time_for_move_centis,
+              long max_time_for_move_centis);
+
+  // Turns a running ponder search into the real search for a move with the
+  // given time limits. Time spent pondering counts against the soft limit
+  // only. May be called from another thread.
+  void PonderHit(long time_for_move_centis, long max_time_for_move_centis);
 
   Board* GetBoard() { return board_; }
 
+  // The reply to the last move returned by Search() that the search expects,
+  // taken from the principal variation. Invalid if the move did not come from
+  // a search, e.g. a book move.
+  Move PonderMove() const { return ponder_move_; }
+
+  // Lazy SMP helpers. Each helper is a complete player with its own board,
+  // move generator and evaluator that shares this player's transposition
+  // table. Helpers search the same position in separate threads while this
+  // player searches, and are stopped as soon as this player's search is done.
+  void SetHelpers(const std::vector<Player*>& helpers) { helpers_ = helpers; }
+
 private:
   const Book* book_;
   Board* board_;
   MoveGenerator* movegen_;
   IterativeDeepener* iterative_deepener_;
   Timer* timer_;
+  TranspositionTable* transpos_;
   EGTB* egtb_;
   Extensions* extensions_;
   int rand_moves_ = 0;
+  Move ponder_move_;
+  std::vector<Player*> helpers_; // not owned.
 };
 
 #endif
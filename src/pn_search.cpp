@@ -103,21 +103,6 @@ void PNSearch::Pns(const PNSParams& pns_params, PNSNode* pns_root) {
   assert(depth == 0);
 }
 
-bool PNSearch::RedundantMoves(PNSNode* pns_node) {
-  if (pns_node && pns_node->parent && pns_node->parent->parent &&
-      pns_node->parent->parent->parent) {
-    const Move& m1 = pns_node->move;
-    const Move& m2 = pns_node->parent->move;
-    const Move& m3 = pns_node->parent->parent->move;
-    const Move& m4 = pns_node->parent->parent->parent->move;
-    if (m1.from_index() == m3.to_index() && m1.to_index() == m3.from_index() &&
-        m2.from_index() == m4.to_index() && m2.to_index() == m4.from_index()) {
-      return true;
-    }
-  }
-  return false;
-}
-
 PNSNode* PNSearch::FindMpn(PNSNode* root, int* depth) {
   PNSNode* mpn = root;
   while (!mpn->children.empty()) {
@@ -205,7 +190,9 @@ void PNSearch::UpdateTreeSize(PNSNode* pns_node) {
 
 void PNSearch::Expand(const PNSParams& pns_params, const int num_nodes,
                       const int pns_node_depth, PNSNode* pns_node) {
-  if (RedundantMoves(pns_node) || pns_node_depth >= PNS_MAX_DEPTH) {
+  // The board is at pns_node. A position repeated below the root is a draw.
+  if ((pns_node->parent && board_->IsRepetition()) ||
+      pns_node_depth >= PNS_MAX_DEPTH) {
     pns_node->proof = INF_NODES;
     pns_node->disproof = INF_NODES;
     assert(pns_node->children.empty());
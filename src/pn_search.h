@@ -93,8 +93,6 @@ private:
 
   int PnNodes(const PNSParams& pns_params, const int num_nodes);
 
-  bool RedundantMoves(PNSNode* pns_node);
-
   PNSNode* FindMpn(PNSNode* pns_node, int* depth);
 
   PNSNode* UpdateAncestors(const PNSParams& pns_params, PNSNode* mpn,
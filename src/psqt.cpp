@@ -0,0 +1,79 @@
+#include "psqt.h"
+#include "common.h"
+#include "piece.h"
+
+namespace {
+// Piece values, in pawns for normal chess.
+namespace normal_pv {
+constexpr int KING = 0;
+constexpr int QUEEN = 9;
+constexpr int ROOK = 5;
+constexpr int BISHOP = 3;
+constexpr int KNIGHT = 3;
+constexpr int PAWN = 1;
+} // namespace normal_pv
+
+namespace suicide_pv {
+constexpr int KING = 10;
+constexpr int QUEEN = 6;
+constexpr int ROOK = 7;
+constexpr int BISHOP = 3;
+constexpr int KNIGHT = 3;
+constexpr int PAWN = 2;
+} // namespace suicide_pv
+
+// Strength of a pawn on each square in normal chess, for both sides.
+// clang-format off
+constexpr int pawn_sq_strength[] = {
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 2, 2, 2, 2, 2, 2, 1,
+  1, 2, 3, 3, 3, 3, 2, 1,
+  1, 2, 3, 5, 5, 3, 2, 1,
+  1, 2, 3, 5, 5, 3, 2, 1,
+  1, 2, 3, 3, 3, 3, 3, 1,
+  1, 2, 2, 2, 2, 2, 2, 1,
+  1, 1, 1, 1, 1, 1, 1, 1
+};
+// clang-format on
+
+void SetMaterial(Piece piece_type, int value, psqt::Table* table) {
+  table->material[PieceIndex(piece_type)] = value;
+  table->material[PieceIndex(-piece_type)] = value;
+}
+
+psqt::Table NormalTable() {
+  psqt::Table table = {};
+  SetMaterial(KING, normal_pv::KING, &table);
+  SetMaterial(QUEEN, normal_pv::QUEEN, &table);
+  SetMaterial(ROOK, normal_pv::ROOK, &table);
+  SetMaterial(BISHOP, normal_pv::BISHOP, &table);
+  SetMaterial(KNIGHT, normal_pv::KNIGHT, &table);
+  SetMaterial(PAWN, normal_pv::PAWN, &table);
+  for (int sq = 0; sq < BOARD_SIZE; ++sq) {
+    table.square[PieceIndex(PAWN)][sq] = pawn_sq_strength[sq];
+    table.square[PieceIndex(-PAWN)][sq] = pawn_sq_strength[sq];
+  }
+  return table;
+}
+
+psqt::Table SuicideTable() {
+  psqt::Table table = {};
+  SetMaterial(KING, suicide_pv::KING, &table);
+  SetMaterial(QUEEN, suicide_pv::QUEEN, &table);
+  SetMaterial(ROOK, suicide_pv::ROOK, &table);
+  SetMaterial(BISHOP, suicide_pv::BISHOP, &table);
+  SetMaterial(KNIGHT, suicide_pv::KNIGHT, &table);
+  SetMaterial(PAWN, suicide_pv::PAWN, &table);
+  return table;
+}
+} // namespace
+
+namespace psqt {
+
+const Table& Get(Variant variant) {
+  static const Table normal_table = NormalTable();
+  static const Table suicide_table = SuicideTable();
+  return variant == Variant::NORMAL ? normal_table : suicide_table;
+}
+
+} // namespace psqt
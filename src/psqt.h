@@ -0,0 +1,25 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include "common.h"
+
+// Material values and piece-square tables of the evaluators. Board keeps the
+// totals of each side up to date as pieces are placed and removed, so that
+// evaluators can read them without scanning the board.
+namespace psqt {
+
+struct Table {
+  // Material value of each piece, indexed by PieceIndex().
+  int material[12];
+
+  // Positional value of each piece on each square, indexed by PieceIndex()
+  // and square index.
+  int square[12][64];
+};
+
+// Returns the table used by the evaluator of given variant.
+const Table& Get(Variant variant);
+
+} // namespace psqt
+
+#endif
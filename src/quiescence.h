@@ -0,0 +1,29 @@
+#ifndef QUIESCENCE_H
+#define QUIESCENCE_H
+
+// Settings for the quiescence search at the leaves of the main search. Instead
+// of evaluating a leaf position in the middle of an exchange, captures are
+// searched until the position is quiet.
+class Quiescence {
+public:
+  Quiescence(const int delta_margin, const int max_depth)
+      : delta_margin_(delta_margin), max_depth_(max_depth) {}
+
+  // Returns true if a capture gaining 'capture_value' cannot raise the static
+  // evaluation 'stand_pat' above alpha, even with a safety margin for
+  // positional gains, so that it need not be searched.
+  bool DeltaPrune(const int stand_pat, const int capture_value,
+                  const int alpha) const {
+    return stand_pat + capture_value + delta_margin_ <= alpha;
+  }
+
+  // Returns true if the quiescence search may not search captures any deeper
+  // and has to settle for the static evaluation.
+  bool DepthExhausted(const int depth) const { return depth >= max_depth_; }
+
+private:
+  const int delta_margin_;
+  const int max_depth_;
+};
+
+#endif
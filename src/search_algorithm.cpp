@@ -2,19 +2,43 @@
 #include "board.h"
 #include "common.h"
 #include "eval.h"
+#include "eval_normal.h"
 #include "extensions.h"
 #include "lmr.h"
 #include "move_order.h"
+#include "move_picker.h"
 #include "movegen.h"
+#include "null_move.h"
+#include "piece.h"
+#include "quiescence.h"
 #include "stats.h"
 #include "timer.h"
 #include "transpos.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 int SearchAlgorithm::NegaScout(int max_depth, int alpha, int beta,
-                               SearchStats* search_stats) {
+                               SearchStats* search_stats, bool verifying) {
+  const int ply = board_->Ply() - root_ply_;
+  if (ply < PV_PLIES) {
+    pv_length_[ply] = ply;
+  }
+
+  // A repeated position is scored as a draw: the side that could avoid the
+  // cycle will do so if it has anything better. The score depends on how the
+  // position was reached, so it is not stored in the transposition table.
+  if (ply > 0 && board_->IsRepetition()) {
+    return DRAW;
+  }
+
   U64 zkey = board_->ZobristKey();
-  TranspositionTableEntry* tentry = transpos_->Get(zkey);
-  if (tentry != nullptr) {
+  const auto tentry = transpos_->Get(zkey);
+  if (!tentry) {
+    ++search_stats->transpos_misses;
+  } else {
+    ++search_stats->transpos_hits;
     if (tentry->node_type == EXACT_NODE &&
         (tentry->score == WIN || tentry->score == -WIN)) {
       return tentry->score;
@@ -27,35 +51,54 @@ int SearchAlgorithm::NegaScout(int max_depth, int alpha, int beta,
     }
   }
 
-  if (max_depth == 0 || (timer_ && timer_->Lapsed())) {
-    ++search_stats->nodes_evaluated;
-    int score = evaluator_->Evaluate();
-    transpos_->Put(score, EXACT_NODE, 0, zkey, Move());
+  const bool timer_lapsed = timer_ && timer_->Lapsed();
+  if (max_depth == 0 && !timer_lapsed && extensions_ &&
+      extensions_->quiescence) {
+    const int score = QuiescenceSearch(0, alpha, beta, search_stats);
+    // The quiescence search result is only a bound if it is outside the
+    // window.
+    NodeType node_type = EXACT_NODE;
+    if (score <= alpha) {
+      node_type = FAIL_LOW_NODE;
+    } else if (score >= beta) {
+      node_type = FAIL_HIGH_NODE;
+    }
+    transpos_->Put(score, node_type, 0, zkey, Move());
     return score;
   }
 
-  MoveArray move_array;
-  movegen_->GenerateMoves(&move_array);
-  if (extensions_ && extensions_->move_orderer) {
-    extensions_->move_orderer->Order(&move_array);
+  // Static evaluations are not stored in the transposition table, where they
+  // would replace search results. Evaluators have a cache of their own.
+  if (max_depth == 0 || timer_lapsed) {
+    ++search_stats->nodes_evaluated;
+    return evaluator_->Evaluate();
   }
 
+  if (extensions_ && extensions_->null_move && !verifying &&
+      NullMovePrunes(max_depth, beta, search_stats)) {
+    return beta;
+  }
+
+  // Moves are generated lazily, starting with the transposition table move
+  // (if available).
+  MovePicker move_picker(
+      movegen_, extensions_ ? extensions_->move_orderer.get() : nullptr,
+      tentry ? tentry->best_move : Move());
+  Move move = move_picker.NextMove();
+
   // We have essentially reached the end of the game, so evaluate.
-  if (move_array.size() == 0) {
+  if (!move.is_valid()) {
     ++search_stats->nodes_evaluated;
     return evaluator_->Evaluate();
   }
-  // Bring up the transposition entry to the top (if available).
-  if (tentry != nullptr && tentry->best_move.is_valid()) {
-    move_array.PushToFront(tentry->best_move);
-  }
 
   Move best_move;
   NodeType node_type = FAIL_LOW_NODE;
   int b = beta;
-  for (size_t index = 0; index < move_array.size(); ++index) {
-    ++search_stats->nodes_searched;
-    const Move& move = move_array.get(index);
+  for (size_t index = 0; move.is_valid();
+       ++index, move = move_picker.NextMove()) {
+    CountNode(search_stats);
+    transpos_->Prefetch(board_->ZobristKeyAfter(move));
     board_->MakeMove(move);
 
     int value = -INF;
@@ -76,22 +119,34 @@ int SearchAlgorithm::NegaScout(int max_depth, int alpha, int beta,
       value = -NegaScout(max_depth - 1, -b, -alpha, search_stats);
     }
 
-    // Re-search with wider window if null window fails high.
-    if (value >= b && value < beta && index > 0 && max_depth > 1) {
+    // Re-search with wider window if null window fails high. Static
+    // evaluations at depth 1 are exact regardless of the window, but
+    // quiescence search results are not.
+    if (value >= b && value < beta && index > 0 &&
+        (max_depth > 1 || (extensions_ && extensions_->quiescence))) {
       ++search_stats->nodes_researched;
       value = -NegaScout(max_depth - 1, -beta, -alpha, search_stats);
     }
 
     board_->UnmakeLastMove();
 
+    // The value is meaningless if the search was stopped below this move.
+    if (timer_ && timer_->Lapsed()) {
+      return alpha;
+    }
+
     if (value > alpha) {
       best_move = move;
       node_type = EXACT_NODE;
       alpha = value;
+      UpdatePrincipalVariation(ply, move);
     }
 
     if (alpha >= beta) {
       node_type = FAIL_HIGH_NODE;
+      if (extensions_ && extensions_->move_orderer) {
+        extensions_->move_orderer->RecordCutoff(move, max_depth);
+      }
       break;
     }
 
@@ -103,3 +158,169 @@ int SearchAlgorithm::NegaScout(int max_depth, int alpha, int beta,
   }
   return alpha;
 }
+
+void SearchAlgorithm::CountNode(SearchStats* search_stats) {
+  ++search_stats->nodes_searched;
+  if (timer_) {
+    timer_->CountNode();
+  }
+}
+
+void SearchAlgorithm::SetRoot() {
+  root_ply_ = board_->Ply();
+  pv_length_[0] = 0;
+}
+
+void SearchAlgorithm::AppendPrincipalVariation(int ply, MoveArray* pv) const {
+  if (ply >= PV_PLIES) {
+    return;
+  }
+  for (int i = ply; i < pv_length_[ply]; ++i) {
+    pv->Add(pv_[ply][i]);
+  }
+}
+
+void SearchAlgorithm::UpdatePrincipalVariation(int ply, const Move& move) {
+  if (ply >= PV_PLIES) {
+    return;
+  }
+  pv_[ply][ply] = move;
+  pv_length_[ply] = ply + 1;
+  if (ply + 1 < PV_PLIES) {
+    for (int i = ply + 1; i < pv_length_[ply + 1]; ++i) {
+      pv_[ply][i] = pv_[ply + 1][i];
+    }
+    pv_length_[ply] = std::max(pv_length_[ply + 1], ply + 1);
+  }
+}
+
+bool SearchAlgorithm::NullMovePrunes(int max_depth, int beta,
+                                     SearchStats* search_stats) {
+  const NullMove& null_move = *extensions_->null_move;
+  if (!null_move.CanTry(max_depth) || beta >= WIN ||
+      board_->LastMoveIsNull()) {
+    return false;
+  }
+  // Without pieces other than pawns, zugzwang is too common to risk a null
+  // move even with verification. Passing while in check is illegal.
+  const Side side = board_->SideToMove();
+  const U64 king_bitboard = board_->BitBoard(PieceOfSide(KING, side));
+  if (board_->BitBoard(side) ==
+          (king_bitboard | board_->BitBoard(PieceOfSide(PAWN, side))) ||
+      InCheck(*board_)) {
+    return false;
+  }
+
+  CountNode(search_stats);
+  board_->MakeNullMove();
+  const int value = -NegaScout(max_depth - 1 - null_move.Reduction(), -beta,
+                               -beta + 1, search_stats);
+  board_->UnmakeNullMove();
+  if (value < beta) {
+    return false;
+  }
+  if (!null_move.NeedsVerification(max_depth)) {
+    return true;
+  }
+  // Confirm that some real move fails high as well, with a search reduced by
+  // as much as the null move search.
+  return NegaScout(max_depth - null_move.Reduction(), beta - 1, beta,
+                   search_stats, true) >= beta;
+}
+
+int SearchAlgorithm::QuiescenceSearch(int depth, int alpha, int beta,
+                                      SearchStats* search_stats) {
+  const Quiescence& quiescence = *extensions_->quiescence;
+  const Side side = board_->SideToMove();
+  const bool in_check = InCheck(*board_);
+
+  // When in check at the first quiescence ply, standing pat is not an option
+  // and all evasions are searched. Deeper in the tree, checks are left to the
+  // static evaluation to keep the quiescence tree small.
+  MoveArray move_array;
+  int stand_pat = -INF;
+  if (in_check && depth == 0) {
+    movegen_->GenerateMoves(&move_array);
+    if (move_array.size() == 0) {
+      return -WIN;
+    }
+    if (extensions_->move_orderer) {
+      extensions_->move_orderer->Order(&move_array);
+    }
+  } else {
+    ++search_stats->nodes_evaluated;
+    stand_pat = evaluator_->Evaluate();
+    if (stand_pat == WIN || stand_pat == -WIN || stand_pat >= beta ||
+        quiescence.DepthExhausted(depth)) {
+      return stand_pat;
+    }
+    alpha = std::max(alpha, stand_pat);
+    movegen_->GenerateCaptures(&move_array);
+    OrderCaptures(&move_array);
+  }
+
+  for (size_t index = 0; index < move_array.size(); ++index) {
+    const Move& move = move_array.get(index);
+    if (stand_pat != -INF) {
+      const int capture_value = CaptureValue(move);
+      if (quiescence.DeltaPrune(stand_pat, capture_value, alpha)) {
+        continue;
+      }
+      // Skip captures that give up a more valuable piece for a defended one.
+      const int attacker_value =
+          EvalNormal::PieceValue(board_->PieceAt(move.from_index()));
+      if (attacker_value > capture_value &&
+          AttackersTo(*board_, move.to_index(), OppositeSide(side))) {
+        continue;
+      }
+    }
+    if (timer_ && timer_->Lapsed()) {
+      break;
+    }
+    CountNode(search_stats);
+    board_->MakeMove(move);
+    const int value = -QuiescenceSearch(depth + 1, -beta, -alpha, search_stats);
+    board_->UnmakeLastMove();
+
+    if (value > alpha) {
+      alpha = value;
+      if (alpha >= beta) {
+        break;
+      }
+    }
+  }
+  return alpha;
+}
+
+int SearchAlgorithm::CaptureValue(const Move& move) const {
+  // The captured square is empty for en passant captures.
+  const Piece captured_piece = board_->PieceAt(move.to_index());
+  int capture_value = EvalNormal::PieceValue(
+      captured_piece == NULLPIECE ? PAWN : captured_piece);
+  if (move.is_promotion()) {
+    capture_value += EvalNormal::PieceValue(move.promoted_piece()) -
+                     EvalNormal::PieceValue(PAWN);
+  }
+  return capture_value;
+}
+
+void SearchAlgorithm::OrderCaptures(MoveArray* move_array) const {
+  // Most valuable victim first, least valuable attacker among equals.
+  std::vector<std::pair<int, Move>> scored_moves;
+  scored_moves.reserve(move_array->size());
+  for (size_t i = 0; i < move_array->size(); ++i) {
+    const Move& move = move_array->get(i);
+    const int attacker_value =
+        EvalNormal::PieceValue(board_->PieceAt(move.from_index()));
+    scored_moves.push_back({CaptureValue(move) * 16 - attacker_value, move});
+  }
+  std::stable_sort(scored_moves.begin(), scored_moves.end(),
+                   [](const std::pair<int, Move>& a,
+                      const std::pair<int, Move>& b) {
+                     return a.first > b.first;
+                   });
+  move_array->clear();
+  for (const auto& scored_move : scored_moves) {
+    move_array->Add(scored_move.second);
+  }
+}
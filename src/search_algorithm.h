@@ -1,9 +1,13 @@
 #ifndef SEARCH_H
 #define SEARCH_H
 
+#include "common.h"
+#include "move.h"
+
 class Board;
 class Evaluator;
 class Extensions;
+class MoveArray;
 class MoveGenerator;
 class Timer;
 class TranspositionTable;
@@ -17,15 +21,57 @@ public:
       : board_(board), movegen_(movegen), timer_(timer), evaluator_(evaluator),
         transpos_(transpos), extensions_(extensions) {}
 
-  int NegaScout(int max_depth, int alpha, int beta, SearchStats* search_stats);
+  // 'verifying' is set for the verification search of a null move, which
+  // must not try another null move at its root.
+  int NegaScout(int max_depth, int alpha, int beta, SearchStats* search_stats,
+                bool verifying = false);
+
+  // Marks the current board position as the root of the search. Plies of the
+  // principal variation are counted from here.
+  void SetRoot();
+
+  // Appends the principal variation of the node last searched at given ply
+  // below the root to 'pv'.
+  void AppendPrincipalVariation(int ply, MoveArray* pv) const;
 
 private:
+  // Returns true if the node fails high even if the side to move passes, so
+  // that it can be pruned without searching the moves.
+  bool NullMovePrunes(int max_depth, int beta, SearchStats* search_stats);
+
+  // Searches captures (or check evasions at the first ply) from a leaf of the
+  // main search until the position is quiet. 'depth' is the number of plies
+  // searched beyond the leaf.
+  int QuiescenceSearch(int depth, int alpha, int beta,
+                       SearchStats* search_stats);
+
+  // Material gained by given capture, including promotion gain.
+  int CaptureValue(const Move& move) const;
+
+  // Orders captures by most valuable victim, then least valuable attacker.
+  void OrderCaptures(MoveArray* move_array) const;
+
+  // Makes 'move' followed by the principal variation of the child node the
+  // principal variation of the node at given ply.
+  void UpdatePrincipalVariation(int ply, const Move& move);
+
+  // Counts a searched node in the stats and against the timer's node limit.
+  void CountNode(SearchStats* search_stats);
+
   Board* board_;
   MoveGenerator* movegen_;
   Timer* timer_;
   Evaluator* evaluator_;
   TranspositionTable* transpos_;
   Extensions* extensions_;
+
+  // Triangular principal variation table. The best line found from the node
+  // at 'ply' plies below the root is pv_[ply][ply .. pv_length_[ply] - 1].
+  // Null moves and reductions keep plies below MAX_DEPTH + 1.
+  static constexpr int PV_PLIES = MAX_DEPTH + 2;
+  Move pv_[PV_PLIES][PV_PLIES];
+  int pv_length_[PV_PLIES] = {};
+  int root_ply_ = 0;
 };
 
 #endif
@@ -6,6 +6,13 @@ struct SearchStats {
   unsigned nodes_searched = 0U;
   unsigned nodes_researched = 0U;
   unsigned nodes_evaluated = 0U;
+  // Number of times an iteration was searched again because its score fell
+  // outside the aspiration window.
+  unsigned aspiration_researches = 0U;
+  // Transposition table probes in the search tree. They are counted per
+  // thread and added to the shared table's totals after the search.
+  unsigned transpos_hits = 0U;
+  unsigned transpos_misses = 0U;
   unsigned search_depth = 0U;
 };
 
@@ -160,6 +160,162 @@ TEST_F(BoardTest, Zobrist2) {
   EXPECT_TRUE(b2 == b4);
 }
 
+// Zobrist keys are generated from a fixed seed, so they must never change
+// between builds. Data keyed by them, like transposition table snapshots, is
+// reused across binaries.
+TEST_F(BoardTest, ZobristKeysAreFixed) {
+  EXPECT_EQ(0x1151242b52a0a770ULL, Board(Variant::NORMAL).ZobristKey());
+  EXPECT_EQ(0x1a12544e3fa71cc9ULL, Board(Variant::SUICIDE).ZobristKey());
+}
+
+// Walks the move tree and checks that the key predicted by ZobristKeyAfter(),
+// the key maintained by MakeMove() and the key of the same position set up
+// from its FEN are all equal.
+void VerifyZobristKeys(MoveGenerator* movegen, Board* board, Variant variant,
+                       int depth) {
+  if (depth == 0) {
+    return;
+  }
+  MoveArray move_array;
+  movegen->GenerateMoves(&move_array);
+  for (size_t i = 0; i < move_array.size(); ++i) {
+    const Move& move = move_array.get(i);
+    const U64 predicted_key = board->ZobristKeyAfter(move);
+    board->MakeMove(move);
+    EXPECT_EQ(board->ZobristKey(), predicted_key) << move.str();
+    EXPECT_EQ(Board(variant, board->ParseIntoFEN()).ZobristKey(),
+              board->ZobristKey())
+        << board->ParseIntoFEN();
+    VerifyZobristKeys(movegen, board, variant, depth - 1);
+    board->UnmakeLastMove();
+  }
+}
+
+TEST_F(BoardTest, ZobristKeyAfterMove) {
+  for (const char* fen :
+       {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq -",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -"}) {
+    Board board(Variant::NORMAL, fen);
+    MoveGeneratorNormal movegen(&board);
+    VerifyZobristKeys(&movegen, &board, Variant::NORMAL, 3);
+  }
+  Board board(Variant::SUICIDE);
+  MoveGeneratorSuicide movegen(board);
+  VerifyZobristKeys(&movegen, &board, Variant::SUICIDE, 3);
+}
+
+// Verifies that material and piece-square totals kept up to date by moves
+// match those of a board set up from scratch, and are restored by undoing the
+// moves.
+void VerifyMaterial(MoveGenerator* movegen, Board* board, Variant variant,
+                    int depth) {
+  if (depth == 0) {
+    return;
+  }
+  MoveArray move_array;
+  movegen->GenerateMoves(&move_array);
+  for (size_t i = 0; i < move_array.size(); ++i) {
+    const Move& move = move_array.get(i);
+    const int white_material = board->Material(Side::WHITE);
+    const int black_psq = board->PieceSquareValue(Side::BLACK);
+    board->MakeMove(move);
+    const Board fresh_board(variant, board->ParseIntoFEN());
+    for (const Side side : {Side::WHITE, Side::BLACK}) {
+      EXPECT_EQ(fresh_board.Material(side), board->Material(side))
+          << board->ParseIntoFEN();
+      EXPECT_EQ(fresh_board.PieceSquareValue(side),
+                board->PieceSquareValue(side))
+          << board->ParseIntoFEN();
+    }
+    VerifyMaterial(movegen, board, variant, depth - 1);
+    board->UnmakeLastMove();
+    EXPECT_EQ(white_material, board->Material(Side::WHITE)) << move.str();
+    EXPECT_EQ(black_psq, board->PieceSquareValue(Side::BLACK)) << move.str();
+  }
+}
+
+TEST_F(BoardTest, IncrementalMaterial) {
+  for (const char* fen :
+       {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq -",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6"}) {
+    Board board(Variant::NORMAL, fen);
+    MoveGeneratorNormal movegen(&board);
+    VerifyMaterial(&movegen, &board, Variant::NORMAL, 2);
+  }
+  Board board(Variant::SUICIDE, "8/P7/8/8/8/8/1p6/R1b5 w - -");
+  MoveGeneratorSuicide movegen(board);
+  VerifyMaterial(&movegen, &board, Variant::SUICIDE, 3);
+
+  // Kings are worth nothing in normal chess and pawns score by square.
+  Board initial(Variant::NORMAL);
+  EXPECT_EQ(39, initial.Material(Side::WHITE));
+  EXPECT_EQ(initial.PieceSquareValue(Side::WHITE),
+            initial.PieceSquareValue(Side::BLACK));
+}
+
+TEST_F(BoardTest, NullMove) {
+  Board board(Variant::NORMAL,
+              "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6");
+  const U64 zkey = board.ZobristKey();
+  EXPECT_FALSE(board.LastMoveIsNull());
+
+  // Passing gives up the en passant capture.
+  board.MakeNullMove();
+  EXPECT_TRUE(board.LastMoveIsNull());
+  EXPECT_EQ(Side::BLACK, board.SideToMove());
+  EXPECT_EQ(-1, board.EnpassantTarget());
+  EXPECT_EQ(
+      Board(Variant::NORMAL,
+            "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR b KQkq -")
+          .ZobristKey(),
+      board.ZobristKey());
+
+  // Moves can be made and unmade on top of a null move.
+  board.MakeMove(Move("g8f6"));
+  EXPECT_FALSE(board.LastMoveIsNull());
+  board.UnmakeLastMove();
+
+  board.UnmakeNullMove();
+  EXPECT_EQ(Side::WHITE, board.SideToMove());
+  EXPECT_EQ(INDX(5, FILE_F), board.EnpassantTarget());
+  EXPECT_EQ(zkey, board.ZobristKey());
+
+  // UnmakeLastMove() also undoes null moves.
+  board.MakeNullMove();
+  EXPECT_TRUE(board.UnmakeLastMove());
+  EXPECT_EQ(zkey, board.ZobristKey());
+}
+
+TEST_F(BoardTest, Repetition) {
+  Board board(Variant::NORMAL);
+  for (const char* move : {"g1f3", "g8f6", "f3g1"}) {
+    board.MakeMove(Move(move));
+    EXPECT_FALSE(board.IsRepetition());
+  }
+  board.MakeMove(Move("f6g8"));
+  EXPECT_TRUE(board.IsRepetition());
+  board.UnmakeLastMove();
+
+  // After a pawn move, only positions from then on can repeat.
+  board.MakeMove(Move("e7e6"));
+  for (const char* move : {"g1f3", "f8e7", "f3g1"}) {
+    board.MakeMove(Move(move));
+    EXPECT_FALSE(board.IsRepetition());
+  }
+  board.MakeMove(Move("e7f8"));
+  EXPECT_TRUE(board.IsRepetition());
+
+  // Null moves also end the scan.
+  Board null_move_board(Variant::SUICIDE);
+  null_move_board.MakeMove(Move("g1f3"));
+  null_move_board.MakeNullMove();
+  null_move_board.MakeMove(Move("f3g1"));
+  null_move_board.MakeNullMove();
+  EXPECT_FALSE(null_move_board.IsRepetition());
+}
+
 TEST_F(BoardTest, CastlingTest) {
   string init_board = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -";
   Board board(Variant::NORMAL, init_board);
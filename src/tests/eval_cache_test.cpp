@@ -0,0 +1,24 @@
+#include "eval_cache.h"
+
+#include <gtest/gtest.h>
+
+TEST(EvalCacheTest, PutAndGet) {
+  EvalCache eval_cache(1000);
+  const U64 zkey = 0x123456789ABCDEF0ULL;
+  EXPECT_FALSE(eval_cache.Get(zkey));
+
+  eval_cache.Put(zkey, -350);
+  ASSERT_TRUE(eval_cache.Get(zkey));
+  EXPECT_EQ(-350, *eval_cache.Get(zkey));
+
+  // Same entry, different position.
+  EXPECT_FALSE(eval_cache.Get(zkey ^ (1ULL << 40)));
+
+  eval_cache.Put(zkey ^ (1ULL << 40), 42);
+  EXPECT_EQ(42, *eval_cache.Get(zkey ^ (1ULL << 40)));
+  EXPECT_FALSE(eval_cache.Get(zkey));
+
+  eval_cache.Put(zkey, 7);
+  eval_cache.Clear();
+  EXPECT_FALSE(eval_cache.Get(zkey));
+}
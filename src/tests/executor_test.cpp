@@ -61,3 +61,52 @@ TEST_F(ExecutorTest, VerifyResult) {
   EXPECT_EQ(1, response.size());
   EXPECT_EQ("0-1 {Black Wins}", response.at(0));
 }
+
+TEST_F(ExecutorTest, LazySMPFindsMate) {
+  const string fen = "6k1/5ppp/8/8/8/8/8/R5K1 w - -";
+  Executor executor("nakshatra-test", fen, Variant::NORMAL);
+  vector<string> response;
+  executor.Execute("new", &response);
+  executor.Execute("cores 4", &response);
+  executor.Execute("thinktime 100", &response);
+  executor.Execute("go", &response);
+  EXPECT_EQ(1, response.size());
+  EXPECT_EQ("move a1a8", response.at(0));
+}
+
+TEST_F(ExecutorTest, HashSizeFromMemoryCommand) {
+  const string fen = "6k1/5ppp/8/8/8/8/8/R5K1 w - -";
+  Executor executor("nakshatra-test", fen, Variant::NORMAL);
+  vector<string> response;
+  executor.Execute("memory 16", &response);
+  executor.Execute("new", &response);
+  executor.Execute("thinktime 100", &response);
+  executor.Execute("go", &response);
+  EXPECT_EQ(1, response.size());
+  EXPECT_EQ("move a1a8", response.at(0));
+}
+
+TEST_F(ExecutorTest, NodeLimitedSearchIsReproducible) {
+  const string fen =
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+  vector<string> moves[2];
+  for (vector<string>& response : moves) {
+    // Pondering is on, but must not change the result.
+    Executor executor("nakshatra-test", fen, Variant::NORMAL);
+    executor.Execute("new", &response);
+    executor.Execute("nobook", &response);
+    executor.Execute("nodes 20000", &response);
+    executor.Execute("go", &response);
+    ASSERT_EQ(1, response.size());
+    // Play the first legal reply, so the next search starts from a position
+    // the search may have pondered on.
+    Board board(Variant::NORMAL, fen);
+    board.MakeMove(Move(response.at(0).substr(5)));
+    MoveGeneratorNormal movegen(&board);
+    MoveArray move_array;
+    movegen.GenerateMoves(&move_array);
+    executor.Execute("usermove " + move_array.get(0).str(), &response);
+    ASSERT_EQ(2, response.size());
+  }
+  EXPECT_EQ(moves[0], moves[1]);
+}
@@ -0,0 +1,39 @@
+#include "board.h"
+#include "common.h"
+#include "move.h"
+#include "move_array.h"
+#include "move_order.h"
+#include "movegen.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+TEST(MoveOrderTest, HistoryOrdererPromotesCutoffMoves) {
+  Board board(Variant::NORMAL, "4k3/8/8/3p4/8/2N5/8/R3K3 w - -");
+  MoveGeneratorNormal movegen(&board);
+  HistoryOrderer orderer(
+      &board, std::unique_ptr<MoveOrderer>(new CapturesFirstOrderer(&board)),
+      MAX_DEPTH);
+  orderer.NewSearch();
+
+  // Both quiet moves become killers at this ply, the most recent one first.
+  orderer.RecordCutoff(Move("c3e4"), 4);
+  orderer.RecordCutoff(Move("a1a7"), 2);
+
+  MoveArray move_array;
+  movegen.GenerateMoves(&move_array);
+  orderer.Order(&move_array);
+  EXPECT_EQ(Move("c3d5"), move_array.get(0));
+  EXPECT_EQ(Move("a1a7"), move_array.get(1));
+  EXPECT_EQ(Move("c3e4"), move_array.get(2));
+
+  // Killers are forgotten in a new search, but history is only aged. The
+  // deeper cutoff by the knight move counts more.
+  orderer.NewSearch();
+  move_array.clear();
+  movegen.GenerateMoves(&move_array);
+  orderer.Order(&move_array);
+  EXPECT_EQ(Move("c3d5"), move_array.get(0));
+  EXPECT_EQ(Move("c3e4"), move_array.get(1));
+  EXPECT_EQ(Move("a1a7"), move_array.get(2));
+}
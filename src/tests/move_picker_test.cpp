@@ -0,0 +1,47 @@
+#include "board.h"
+#include "common.h"
+#include "move.h"
+#include "move_array.h"
+#include "move_order.h"
+#include "move_picker.h"
+#include "movegen.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+TEST(MovePickerTest, YieldsEachMoveOnceInStages) {
+  Board board(Variant::NORMAL, "4k3/8/8/3p4/8/2N5/8/R3K3 w - -");
+  MoveGeneratorNormal movegen(&board);
+  HistoryOrderer orderer(
+      &board, std::unique_ptr<MoveOrderer>(new CapturesFirstOrderer(&board)),
+      0 /* base orderer plies */);
+  orderer.NewSearch();
+  orderer.RecordCutoff(Move("c3e4"), 1);
+  orderer.RecordCutoff(Move("a1a7"), 1);
+  orderer.RecordCutoff(Move("c3b5"), 3);
+
+  MovePicker move_picker(&movegen, &orderer, Move("e1d1"));
+  MoveArray picked;
+  for (Move move = move_picker.NextMove(); move.is_valid();
+       move = move_picker.NextMove()) {
+    EXPECT_FALSE(picked.Contains(move)) << move.str();
+    picked.Add(move);
+  }
+
+  MoveArray move_array;
+  movegen.GenerateMoves(&move_array);
+  ASSERT_EQ(move_array.size(), picked.size());
+  EXPECT_EQ(Move("e1d1"), picked.get(0)); // transposition table move
+  EXPECT_EQ(Move("c3d5"), picked.get(1)); // capture
+  EXPECT_EQ(Move("c3b5"), picked.get(2)); // killers
+  EXPECT_EQ(Move("a1a7"), picked.get(3));
+  EXPECT_EQ(Move("c3e4"), picked.get(4)); // quiet with highest history
+}
+
+TEST(MovePickerTest, SkipsIllegalTranspositionTableMove) {
+  Board board(Variant::SUICIDE, "8/8/8/8/8/2p5/1P6/8 w - -");
+  MoveGeneratorSuicide movegen(board);
+  MovePicker move_picker(&movegen, nullptr, Move("b2b3"));
+  EXPECT_EQ(Move("b2c3"), move_picker.NextMove());
+  EXPECT_FALSE(move_picker.NextMove().is_valid());
+}
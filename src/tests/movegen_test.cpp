@@ -5,6 +5,8 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 using std::string;
 
@@ -282,6 +284,82 @@ TEST_F(MoveGeneratorTest, VerifyPinnedPieceMoves) {
   }
 }
 
+TEST_F(MoveGeneratorTest, VerifyCaptures) {
+  // Both white pawn and queen are pinned, so c3a5 is the only legal capture.
+  Board board(Variant::NORMAL, "8/8/4r3/b7/3b4/2Q2p2/4P3/4K3 w - -");
+  MoveGeneratorNormal movegen(&board);
+  MoveArray move_array;
+  movegen.GenerateCaptures(&move_array);
+  EXPECT_EQ(1U, move_array.size());
+  EXPECT_EQ(Move("c3a5"), move_array.get(0));
+
+  Board suicide_board(Variant::SUICIDE, "8/8/8/8/8/2p5/1P6/8 w - -");
+  MoveGeneratorSuicide suicide_movegen(suicide_board);
+  move_array.clear();
+  suicide_movegen.GenerateCaptures(&move_array);
+  EXPECT_EQ(1U, move_array.size());
+  EXPECT_EQ(Move("b2c3"), move_array.get(0));
+  suicide_board.MakeMove(Move("b2b3"));
+  move_array.clear();
+  suicide_movegen.GenerateCaptures(&move_array);
+  EXPECT_EQ(0U, move_array.size());
+}
+
+// Checks that captures and quiet moves partition the legal moves and that
+// IsValidMove() accepts exactly the legal moves.
+void VerifyMoveSubsets(MoveGenerator* movegen, const Side side) {
+  MoveArray moves, captures, quiets;
+  movegen->GenerateMoves(&moves);
+  movegen->GenerateCaptures(&captures);
+  movegen->GenerateQuiets(&quiets);
+  EXPECT_EQ(moves.size(), captures.size() + quiets.size());
+  for (size_t i = 0; i < captures.size(); ++i) {
+    EXPECT_TRUE(moves.Contains(captures.get(i)));
+    EXPECT_FALSE(quiets.Contains(captures.get(i)));
+  }
+  for (size_t i = 0; i < quiets.size(); ++i) {
+    EXPECT_TRUE(moves.Contains(quiets.get(i)));
+  }
+
+  for (int from = 0; from < BOARD_SIZE; ++from) {
+    for (int to = 0; to < BOARD_SIZE; ++to) {
+      if (from == to) {
+        continue;
+      }
+      for (Piece promoted = NULLPIECE; promoted <= PAWN; ++promoted) {
+        const Move move(from, to, PieceOfSide(promoted, side));
+        EXPECT_EQ(moves.Contains(move), movegen->IsValidMove(move))
+            << move.str();
+      }
+    }
+  }
+}
+
+TEST_F(MoveGeneratorTest, VerifyMoveSubsets) {
+  const string normal_fens[] = {
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq -",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -",
+      "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ -",
+      "8/8/4r3/b7/3b4/2Q2p2/4P3/4K3 w - -",
+      "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6"};
+  for (const string& fen : normal_fens) {
+    Board board(Variant::NORMAL, fen);
+    MoveGeneratorNormal movegen(&board);
+    VerifyMoveSubsets(&movegen, board.SideToMove());
+  }
+
+  const string suicide_fens[] = {
+      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - -",
+      "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w - -",
+      "8/1P6/8/8/8/8/6p1/8 b - -"};
+  for (const string& fen : suicide_fens) {
+    Board board(Variant::SUICIDE, fen);
+    MoveGeneratorSuicide movegen(board);
+    VerifyMoveSubsets(&movegen, board.SideToMove());
+  }
+}
+
 TEST_F(MoveGeneratorTest, VerifyMovesUnderCheck) {
   Board board(Variant::NORMAL,
               "rnb1kbnr/pppp1p1p/6p1/4P3/1q2P3/8/PPPK1PPP/RNBQ1BNR w KQkq -");
@@ -392,3 +470,130 @@ TEST_F(MoveGeneratorTest, CountMoves) {
   EXPECT_EQ(53392, CountLeafMoves(&movegen, &board, 3));
   EXPECT_EQ(1761505, CountLeafMoves(&movegen, &board, 4));
 }
+
+// Checks CountMovesBothSides() against CountMoves() of each side in every
+// position reached from the board up to given depth.
+void CheckCountMovesBothSides(MoveGeneratorSuicide* movegen, Board* board,
+                              int depth) {
+  const SuicideMoveCounts move_counts = movegen->CountMovesBothSides();
+  const Side side = board->SideToMove();
+  MoveArray move_array;
+  movegen->GenerateMoves(&move_array);
+  MoveArray captures;
+  movegen->GenerateCaptures(&captures);
+  ASSERT_EQ(move_array.size(), move_counts.num_moves[SideIndex(side)])
+      << board->ParseIntoFEN();
+  ASSERT_EQ(captures.size() > 0, move_counts.must_capture[SideIndex(side)]);
+
+  board->FlipSideToMove();
+  MoveArray opp_captures;
+  movegen->GenerateCaptures(&opp_captures);
+  ASSERT_EQ(movegen->CountMoves(),
+            move_counts.num_moves[SideIndex(OppositeSide(side))])
+      << board->ParseIntoFEN();
+  ASSERT_EQ(opp_captures.size() > 0,
+            move_counts.must_capture[SideIndex(OppositeSide(side))]);
+  board->FlipSideToMove();
+
+  if (depth == 0) {
+    return;
+  }
+  for (size_t i = 0; i < move_array.size(); ++i) {
+    board->MakeMove(move_array.get(i));
+    CheckCountMovesBothSides(movegen, board, depth - 1);
+    board->UnmakeLastMove();
+  }
+}
+
+TEST_F(MoveGeneratorTest, CountMovesBothSides) {
+  for (const char* fen :
+       {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - -",
+        "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b - e3",
+        "8/1P4k1/8/2p5/8/5q2/6p1/R3K3 w - -"}) {
+    Board board(Variant::SUICIDE, fen);
+    MoveGeneratorSuicide movegen(board);
+    CheckCountMovesBothSides(&movegen, &board, 3);
+  }
+}
+
+TEST_F(MoveGeneratorTest, AttackersTo) {
+  Board board(Variant::NORMAL, "4k3/8/2n2q2/8/1P1p4/2N5/8/R3K2R w KQ -");
+  EXPECT_EQ(1ULL << INDX(3, 1), AttackersTo(board, INDX(4, 2), Side::WHITE));
+  EXPECT_EQ(1ULL << INDX(3, 3), AttackersTo(board, INDX(2, 2), Side::BLACK));
+  EXPECT_EQ((1ULL << INDX(5, 2)) | (1ULL << INDX(5, 5)),
+            AttackersTo(board, INDX(4, 4), Side::BLACK));
+  EXPECT_EQ(1ULL << INDX(5, 5), AttackersTo(board, INDX(0, 5), Side::BLACK));
+  EXPECT_FALSE(InCheck(board));
+}
+
+// Checks GivesCheck() against InCheck() after the move, for every move up to
+// given depth.
+void CheckGivesCheck(MoveGenerator* movegen, Board* board, int depth) {
+  MoveArray move_array;
+  movegen->GenerateMoves(&move_array);
+  for (size_t i = 0; i < move_array.size(); ++i) {
+    const Move& move = move_array.get(i);
+    const bool gives_check = GivesCheck(board, move);
+    board->MakeMove(move);
+    ASSERT_EQ(InCheck(*board), gives_check) << board->ParseIntoFEN();
+    if (depth > 1) {
+      CheckGivesCheck(movegen, board, depth - 1);
+    }
+    board->UnmakeLastMove();
+  }
+}
+
+TEST_F(MoveGeneratorTest, GivesCheck) {
+  for (const char* fen :
+       {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq -"}) {
+    Board board(Variant::NORMAL, fen);
+    MoveGeneratorNormal movegen(&board);
+    CheckGivesCheck(&movegen, &board, 3);
+  }
+}
+
+// Same as CountLeafMoves(), with the leaves counted by CountMoves().
+int CountLeafMovesBulk(MoveGenerator* movegen, Board* board,
+                       unsigned int depth) {
+  if (depth == 1) {
+    return movegen->CountMoves();
+  }
+
+  MoveArray move_array;
+  movegen->GenerateMoves(&move_array);
+  int nodes = 0;
+  for (size_t i = 0; i < move_array.size(); ++i) {
+    board->MakeMove(move_array.get(i));
+    nodes += CountLeafMovesBulk(movegen, board, depth - 1);
+    board->UnmakeLastMove();
+  }
+  return nodes;
+}
+
+TEST_F(MoveGeneratorTest, Perft) {
+  // Standard perft positions with pins, discovered checks, en passant
+  // captures that expose the king, castling and promotions.
+  const std::vector<std::pair<string, std::vector<U64>>> positions = {
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -",
+       {20, 400, 8902, 197281}},
+      {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+       {48, 2039, 97862}},
+      {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -", {14, 191, 2812, 43238, 674624}},
+      {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq -",
+       {6, 264, 9467}},
+      {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ -",
+       {44, 1486, 62379}}};
+  for (const auto& [fen, nodes] : positions) {
+    Board board(Variant::NORMAL, fen);
+    MoveGeneratorNormal movegen(&board);
+    for (size_t depth = 1; depth <= nodes.size(); ++depth) {
+      EXPECT_EQ(nodes[depth - 1], CountLeafMoves(&movegen, &board, depth))
+          << fen << " at depth " << depth;
+      EXPECT_EQ(nodes[depth - 1],
+                CountLeafMovesBulk(&movegen, &board, depth))
+          << fen << " at depth " << depth;
+    }
+  }
+}
@@ -1,10 +1,19 @@
 #include "board.h"
 #include "common.h"
 #include "eval.h"
+#include "eval_normal.h"
 #include "eval_suicide.h"
+#include "extensions.h"
+#include "iterative_deepener.h"
+#include "lmr.h"
+#include "move_order.h"
 #include "movegen.h"
+#include "null_move.h"
+#include "pn_search.h"
+#include "quiescence.h"
 #include "search_algorithm.h"
 #include "stats.h"
+#include "timer.h"
 #include "transpos.h"
 
 #include <gtest/gtest.h>
@@ -21,7 +30,8 @@ TEST_F(SearchAlgorithmTest, NegaScout) {
   const std::string board_str = "8/R7/8/8/8/8/8/7k w - -";
   Board board(Variant::SUICIDE, board_str);
 
-  std::unique_ptr<MoveGenerator> movegen(new MoveGeneratorSuicide(board));
+  std::unique_ptr<MoveGeneratorSuicide> movegen(
+      new MoveGeneratorSuicide(board));
   std::unique_ptr<Evaluator> eval(
       new EvalSuicide(&board, movegen.get(), nullptr));
 
@@ -40,3 +50,128 @@ TEST_F(SearchAlgorithmTest, NegaScout) {
   SearchStats search_stats;
   EXPECT_EQ(WIN, search_algorithm.NegaScout(7, -INF, INF, &search_stats));
 }
+
+TEST_F(SearchAlgorithmTest, QuiescenceSeesRecapture) {
+  // The pawn on d5 is defended, so Qxd5 loses the queen for two pawns.
+  Board board(Variant::NORMAL, "4k3/8/4p3/3p4/8/8/8/3QK3 w - -");
+  MoveGeneratorNormal movegen(&board);
+  EvalNormal eval(&board, &movegen);
+  Extensions extensions;
+  extensions.move_orderer.reset(new CapturesFirstOrderer(&board));
+
+  TranspositionTable transpos(1U << 16);
+  SearchAlgorithm search_algorithm(&board, &movegen, &eval, nullptr, &transpos,
+                                   &extensions);
+  SearchStats search_stats;
+  const int score = search_algorithm.NegaScout(1, -INF, INF, &search_stats);
+
+  extensions.quiescence.reset(new Quiescence(50, 8));
+  TranspositionTable qs_transpos(1U << 16);
+  SearchAlgorithm qs_search_algorithm(&board, &movegen, &eval, nullptr,
+                                      &qs_transpos, &extensions);
+  SearchStats qs_search_stats;
+  const int qs_score =
+      qs_search_algorithm.NegaScout(1, -INF, INF, &qs_search_stats);
+
+  // Without quiescence search, winning the pawn looks best. With it, the
+  // recapture is seen and white gains nothing.
+  EXPECT_LT(qs_score, score - EvalNormal::PieceValue(PAWN) / 2);
+}
+
+TEST_F(SearchAlgorithmTest, PrincipalVariation) {
+  Board board(Variant::NORMAL, "6k1/5ppp/8/8/8/8/8/R5K1 w - -");
+  MoveGeneratorNormal movegen(&board);
+  EvalNormal eval(&board, &movegen);
+  TranspositionTable transpos(1U << 16);
+  SearchAlgorithm search_algorithm(&board, &movegen, &eval, nullptr, &transpos,
+                                   nullptr);
+  search_algorithm.SetRoot();
+  SearchStats search_stats;
+  EXPECT_EQ(WIN, search_algorithm.NegaScout(3, -INF, INF, &search_stats));
+
+  // Mate in one, so the variation ends with the mating move.
+  MoveArray pv;
+  search_algorithm.AppendPrincipalVariation(0, &pv);
+  ASSERT_EQ(1U, pv.size());
+  EXPECT_EQ(Move("a1a8"), pv.get(0));
+
+  // Every move of a longer variation is legal when played in order.
+  Board kiwipete(
+      Variant::NORMAL,
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+  MoveGeneratorNormal kiwipete_movegen(&kiwipete);
+  EvalNormal kiwipete_eval(&kiwipete, &kiwipete_movegen);
+  TranspositionTable kiwipete_transpos(1U << 16);
+  SearchAlgorithm kiwipete_search(&kiwipete, &kiwipete_movegen,
+                                  &kiwipete_eval, nullptr, &kiwipete_transpos,
+                                  nullptr);
+  kiwipete_search.SetRoot();
+  kiwipete_search.NegaScout(3, -INF, INF, &search_stats);
+  pv.clear();
+  kiwipete_search.AppendPrincipalVariation(0, &pv);
+  EXPECT_EQ(3U, pv.size());
+  for (size_t i = 0; i < pv.size(); ++i) {
+    EXPECT_TRUE(kiwipete_movegen.IsValidMove(pv.get(i))) << pv.get(i).str();
+    kiwipete.MakeMove(pv.get(i));
+  }
+}
+
+TEST_F(SearchAlgorithmTest, NodeLimit) {
+  const std::string fen =
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+  int scores[2];
+  for (int& score : scores) {
+    Board board(Variant::NORMAL, fen);
+    MoveGeneratorNormal movegen(&board);
+    EvalNormal eval(&board, &movegen);
+    Extensions extensions;
+    extensions.quiescence.reset(new Quiescence(100, 4));
+    TranspositionTable transpos(1U << 16);
+    Timer timer;
+    timer.Reset();
+    timer.SetNodeLimit(5000);
+    SearchAlgorithm search_algorithm(&board, &movegen, &eval, &timer,
+                                     &transpos, &extensions);
+    SearchStats search_stats;
+    score = search_algorithm.NegaScout(8, -INF, INF, &search_stats);
+
+    // The search stops at exactly the node limit.
+    EXPECT_TRUE(timer.Lapsed());
+    EXPECT_EQ(5000U, timer.NodesCounted());
+    EXPECT_EQ(5000U, search_stats.nodes_searched);
+  }
+  EXPECT_EQ(scores[0], scores[1]);
+}
+
+TEST_F(SearchAlgorithmTest, NodeLimitedIterativeDeepening) {
+  const std::string fen =
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+  Move best_moves[2];
+  int scores[2];
+  unsigned nodes_searched[2];
+  for (int i = 0; i < 2; ++i) {
+    Board board(Variant::NORMAL, fen);
+    MoveGeneratorNormal movegen(&board);
+    EvalNormal eval(&board, &movegen);
+    Extensions extensions;
+    extensions.quiescence.reset(new Quiescence(100, 4));
+    TranspositionTable transpos(1U << 16);
+    Timer timer;
+    timer.Reset();
+    timer.SetNodeLimit(20000);
+    SearchAlgorithm search_algorithm(&board, &movegen, &eval, &timer,
+                                     &transpos, &extensions);
+    IterativeDeepener iterative_deepener(&board, &movegen, &search_algorithm,
+                                         &timer, &transpos, &extensions);
+    IDSParams ids_params;
+    SearchStats search_stats;
+    iterative_deepener.Search(ids_params, &best_moves[i], &scores[i],
+                              &search_stats);
+    nodes_searched[i] = search_stats.nodes_searched;
+    EXPECT_EQ(20000U, timer.NodesCounted());
+  }
+  EXPECT_TRUE(best_moves[0].is_valid());
+  EXPECT_EQ(best_moves[0], best_moves[1]);
+  EXPECT_EQ(scores[0], scores[1]);
+  EXPECT_EQ(nodes_searched[0], nodes_searched[1]);
+}
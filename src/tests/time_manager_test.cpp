@@ -0,0 +1,27 @@
+#include "move.h"
+#include "time_manager.h"
+
+#include <gtest/gtest.h>
+
+TEST(TimeManagerTest, StopsEarlyWhenBestMoveIsStable) {
+  TimeManager time_manager(100, 300);
+  // The best move takes most of the nodes, but is not yet stable.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FALSE(time_manager.IterationDone(Move("e2e4"), 20, 90, 100, 30));
+  }
+  EXPECT_DOUBLE_EQ(100, time_manager.ScaledSoftLimit());
+  // Stable for three iterations now, so the soft limit is halved.
+  EXPECT_TRUE(time_manager.IterationDone(Move("e2e4"), 20, 90, 100, 30));
+  EXPECT_DOUBLE_EQ(50, time_manager.ScaledSoftLimit());
+}
+
+TEST(TimeManagerTest, ExtendsWhenBestMoveChangesOrScoreDrops) {
+  TimeManager time_manager(100, 300);
+  EXPECT_FALSE(time_manager.IterationDone(Move("e2e4"), 20, 50, 100, 10));
+  EXPECT_FALSE(time_manager.IterationDone(Move("d2d4"), 20, 50, 100, 60));
+  EXPECT_DOUBLE_EQ(200, time_manager.ScaledSoftLimit());
+  // A large score drop doubles the soft limit, capped by the hard limit.
+  EXPECT_FALSE(time_manager.IterationDone(Move("d2d4"), -200, 50, 100, 60));
+  EXPECT_DOUBLE_EQ(300, time_manager.ScaledSoftLimit());
+  EXPECT_TRUE(time_manager.IterationDone(Move("d2d4"), -200, 50, 100, 160));
+}
@@ -0,0 +1,66 @@
+#include "timer.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace {
+
+// Polls the timer until it lapses. Returns the number of polls.
+unsigned PollUntilLapsed(const Timer& timer) {
+  unsigned polls = 1;
+  while (!timer.Lapsed()) {
+    ++polls;
+  }
+  return polls;
+}
+
+} // namespace
+
+TEST(TimerTest, LapsesWithinPollInterval) {
+  Timer timer;
+  timer.Reset();
+  timer.Run(1); // 10 ms
+  EXPECT_FALSE(timer.Lapsed());
+  EXPECT_EQ(-1, timer.LatencyMicros());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_LE(PollUntilLapsed(timer), Timer::POLL_INTERVAL);
+  EXPECT_GE(timer.LatencyMicros(), 10000);
+  EXPECT_TRUE(timer.Lapsed());
+
+  timer.Reset();
+  EXPECT_FALSE(timer.Lapsed());
+  EXPECT_EQ(-1, timer.LatencyMicros());
+}
+
+TEST(TimerTest, ExpireAndInvalidate) {
+  Timer timer;
+  timer.Reset();
+  timer.Run(0);
+  EXPECT_TRUE(timer.Lapsed());
+
+  timer.Reset();
+  timer.Run(100 * 100);
+  timer.Expire();
+  EXPECT_TRUE(timer.Lapsed());
+  timer.Reset();
+  EXPECT_FALSE(timer.Lapsed());
+
+  timer.Invalidate();
+  EXPECT_TRUE(timer.Lapsed());
+  timer.Reset();
+  EXPECT_TRUE(timer.Lapsed());
+}
+
+TEST(TimerTest, StoppedFromAnotherThread) {
+  Timer timer;
+  timer.Reset();
+  timer.Run(100 * 100);
+  std::thread searcher([&timer] { PollUntilLapsed(timer); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  timer.Invalidate();
+  searcher.join();
+  EXPECT_TRUE(timer.Lapsed());
+  EXPECT_EQ(-1, timer.LatencyMicros());
+}
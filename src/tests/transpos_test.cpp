@@ -5,12 +5,17 @@
 #include "zobrist.h"
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
 TEST(TransposTest, VerifyEntries) {
   Board board(Variant::SUICIDE,
               "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - -");
   TranspositionTable t(1024);
   U64 zkey = board.ZobristKey();
-  EXPECT_EQ(NULL, t.Get(zkey));
+  EXPECT_FALSE(t.Get(zkey));
 
   Move m("e2e3");
   t.Put(1000, FAIL_HIGH_NODE, 10, zkey, m);
@@ -19,4 +24,124 @@ TEST(TransposTest, VerifyEntries) {
   EXPECT_EQ(10, t.Get(zkey)->depth);
   EXPECT_EQ(zkey, t.Get(zkey)->zkey);
   EXPECT_EQ(m.encoded_move(), t.Get(zkey)->best_move.encoded_move());
+
+  t.Put(-WIN, EXACT_NODE, 0, zkey + 1, Move());
+  EXPECT_EQ(-WIN, t.Get(zkey + 1)->score);
+  EXPECT_FALSE(t.Get(zkey + 1)->best_move.is_valid());
+}
+
+TEST(TransposTest, ReplaceShallowestEntryInCluster) {
+  TranspositionTable t(CLUSTER_SIZE);
+  for (int i = 0; i < CLUSTER_SIZE; ++i) {
+    t.Put(i, EXACT_NODE, 10 - i, i, Move());
+  }
+  t.Put(100, EXACT_NODE, 1, 100, Move());
+  EXPECT_FALSE(t.Get(CLUSTER_SIZE - 1));
+  EXPECT_EQ(100, t.Get(100)->score);
+  for (int i = 0; i < CLUSTER_SIZE - 1; ++i) {
+    EXPECT_EQ(i, t.Get(i)->score);
+  }
+
+  // An entry for the same position is overwritten if it is not much deeper.
+  t.Put(200, FAIL_LOW_NODE, 8, 0, Move());
+  EXPECT_EQ(200, t.Get(0)->score);
+  EXPECT_EQ(8, t.Get(0)->depth);
+
+  // A shallow bound does not replace a deep entry for the same position.
+  t.Put(300, FAIL_HIGH_NODE, 0, 0, Move());
+  EXPECT_EQ(200, t.Get(0)->score);
+  EXPECT_EQ(8, t.Get(0)->depth);
+
+  // An exact score replaces a deep bound.
+  t.Put(400, EXACT_NODE, 0, 0, Move());
+  EXPECT_EQ(400, t.Get(0)->score);
+  EXPECT_EQ(0, t.Get(0)->depth);
+}
+
+TEST(TransposTest, ReplaceStaleEntries) {
+  TranspositionTable t(CLUSTER_SIZE);
+  for (int i = 0; i < CLUSTER_SIZE; ++i) {
+    t.Put(i, EXACT_NODE, 20 + i, i, Move());
+  }
+  t.NewSearch();
+  t.NewSearch();
+  t.NewSearch();
+  // Storing an entry again keeps it current.
+  t.Put(0, EXACT_NODE, 20, 0, Move());
+  t.Put(100, EXACT_NODE, 1, 100, Move());
+  EXPECT_TRUE(t.Get(0));
+  EXPECT_TRUE(t.Get(100));
+  // The shallowest of the stale entries is replaced, even though it is much
+  // deeper than the new one.
+  EXPECT_FALSE(t.Get(1));
+  EXPECT_TRUE(t.Get(2));
+  EXPECT_TRUE(t.Get(3));
+}
+
+TEST(TransposTest, SaveAndLoadSnapshot) {
+  const std::string filename = testing::TempDir() + "transpos_snapshot";
+  TranspositionTable t(1024);
+  t.Put(100, EXACT_NODE, 8, 1, Move("e2e3"));
+  t.Put(-WIN, EXACT_NODE, 0, 2, Move());
+  t.Put(50, FAIL_HIGH_NODE, 2, 3, Move("d2d4"));
+  EXPECT_TRUE(t.Save(filename, Variant::SUICIDE, 6));
+
+  TranspositionTable t2(1024);
+  EXPECT_FALSE(t2.Load(filename, Variant::NORMAL));
+  EXPECT_FALSE(t2.Get(1));
+  EXPECT_TRUE(t2.Load(filename, Variant::SUICIDE));
+  EXPECT_EQ(100, t2.Get(1)->score);
+  EXPECT_EQ(8, t2.Get(1)->depth);
+  EXPECT_EQ(Move("e2e3"), t2.Get(1)->best_move);
+  EXPECT_EQ(-WIN, t2.Get(2)->score);
+  EXPECT_FALSE(t2.Get(3));
+  std::remove(filename.c_str());
+
+  EXPECT_FALSE(t2.Load(filename, Variant::SUICIDE));
+}
+
+// Several threads store and probe keys that all collide in a tiny table. The
+// contents of every entry are derived from its key, so a probe that returns a
+// mix of two writes is detected.
+TEST(TransposTest, ConcurrentAccess) {
+  TranspositionTable t(2);
+  auto score = [](U64 zkey) { return static_cast<int>(zkey % 20000) - 10000; };
+  auto depth = [](U64 zkey) { return static_cast<int>((zkey >> 8) % 64); };
+  auto move = [](U64 zkey) {
+    return Move(zkey % 64, (zkey / 64 + 1 + zkey % 64) % 64);
+  };
+
+  std::vector<std::thread> threads;
+  std::vector<int> bad_entries(4, 0);
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&, i] {
+      U64 zkey = 0x9E3779B97F4A7C15ULL * (i + 1);
+      for (int j = 0; j < 200000; ++j) {
+        zkey = zkey * 6364136223846793005ULL + 1442695040888963407ULL;
+        t.Put(score(zkey), EXACT_NODE, depth(zkey), zkey, move(zkey));
+        for (U64 probe : {zkey, zkey ^ U64(1)}) {
+          if (auto tentry = t.Get(probe);
+              tentry && (tentry->score != score(probe) ||
+                         tentry->depth != depth(probe) ||
+                         tentry->best_move != move(probe))) {
+            ++bad_entries[i];
+          }
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int bad : bad_entries) {
+    EXPECT_EQ(0, bad);
+  }
+}
+
+TEST(TransposTest, SizeForLargeMemory) {
+  // 32 GB and more don't fit in an int worth of bytes.
+  EXPECT_EQ(2 * TranspositionTable::SizeForMegabytes(16384),
+            TranspositionTable::SizeForMegabytes(32768));
+  EXPECT_EQ(64 * TranspositionTable::SizeForMegabytes(1024),
+            TranspositionTable::SizeForMegabytes(65536));
 }
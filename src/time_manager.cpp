@@ -0,0 +1,59 @@
+#include "time_manager.h"
+#include "common.h"
+
+#include <algorithm>
+
+namespace {
+// Share of the nodes the best move must take for the position to count as
+// easy once the best move has been stable for EASY_MOVE_ITERATIONS.
+const double EASY_MOVE_NODES_SHARE = 0.8;
+const int EASY_MOVE_ITERATIONS = 3;
+
+// A score drop of SCORE_DROP_LIMIT or more doubles the soft limit.
+const int SCORE_DROP_LIMIT = 100;
+} // namespace
+
+bool TimeManager::IterationDone(const Move& best_move, int score,
+                                unsigned best_move_nodes, unsigned total_nodes,
+                                double elapsed_centis) {
+  best_move_changes_ /= 2;
+  score_drop_factor_ = 1.0;
+  if (iterations_ > 0) {
+    if (best_move == best_move_) {
+      ++stable_iterations_;
+    } else {
+      stable_iterations_ = 0;
+      best_move_changes_ += 1.0;
+    }
+    // Mate scores say nothing about how critical the position is.
+    if (score > -WIN && score < WIN && score_ > -WIN && score_ < WIN &&
+        score < score_) {
+      score_drop_factor_ +=
+          static_cast<double>(std::min(score_ - score, SCORE_DROP_LIMIT)) /
+          SCORE_DROP_LIMIT;
+    }
+  }
+  ++iterations_;
+  best_move_ = best_move;
+  score_ = score;
+
+  easy_move_factor_ = 1.0;
+  if (stable_iterations_ >= EASY_MOVE_ITERATIONS && total_nodes > 0 &&
+      best_move_nodes >= EASY_MOVE_NODES_SHARE * total_nodes) {
+    easy_move_factor_ = 0.5;
+  }
+
+  return OutOfTime(elapsed_centis);
+}
+
+bool TimeManager::OutOfTime(double elapsed_centis) const {
+  // The next iteration usually takes longer than all the previous ones
+  // together, so it is not started past half of the soft limit.
+  return soft_limit_centis_ > 0 && elapsed_centis >= ScaledSoftLimit() / 2;
+}
+
+double TimeManager::ScaledSoftLimit() const {
+  return std::min(hard_limit_centis_,
+                  soft_limit_centis_ * (1.0 + best_move_changes_) *
+                      score_drop_factor_ * easy_move_factor_);
+}
@@ -0,0 +1,59 @@
+#ifndef TIME_MANAGER_H
+#define TIME_MANAGER_H
+
+#include "move.h"
+
+// Decides after every iteration of the iterative deepening search whether
+// another iteration is worth its time. The soft limit is the time a move is
+// expected to take. It shrinks when the best move has been stable for a few
+// iterations and took most of the nodes, and grows when the best move changes
+// or the score drops, but it never exceeds the hard limit. The hard limit
+// itself is enforced by the Timer, which interrupts a running iteration.
+//
+// Limits may be set after the search began, e.g. when a ponder search becomes
+// the real search. Until then, the search is never stopped.
+class TimeManager {
+public:
+  TimeManager() {}
+
+  TimeManager(double soft_limit_centis, double hard_limit_centis) {
+    SetLimits(soft_limit_centis, hard_limit_centis);
+  }
+
+  // Limits are in centiseconds since the search began.
+  void SetLimits(double soft_limit_centis, double hard_limit_centis) {
+    soft_limit_centis_ = soft_limit_centis;
+    hard_limit_centis_ = hard_limit_centis;
+  }
+
+  // Called after every iteration with its best move and score, the nodes
+  // searched below the best move and in total, and the time elapsed since the
+  // search began. Returns true if the search should stop.
+  bool IterationDone(const Move& best_move, int score, unsigned best_move_nodes,
+                     unsigned total_nodes, double elapsed_centis);
+
+  // Returns true if the search should not start another iteration.
+  bool OutOfTime(double elapsed_centis) const;
+
+  // Soft limit scaled by the stability of the search so far.
+  double ScaledSoftLimit() const;
+
+private:
+  double soft_limit_centis_ = 0.0;
+  double hard_limit_centis_ = 0.0;
+
+  int iterations_ = 0;
+  Move best_move_;
+  int score_ = 0;
+
+  // Number of consecutive iterations that found the same best move.
+  int stable_iterations_ = 0;
+
+  // Factors by which the soft limit is scaled. best_move_changes_ decays every
+  // iteration so that only recent changes of mind count.
+  double best_move_changes_ = 0.0;
+  double score_drop_factor_ = 1.0;
+  double easy_move_factor_ = 1.0;
+};
+
+#endif
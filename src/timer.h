@@ -3,83 +3,126 @@
 
 #include "common.h"
 
-#include <cstdio>
-#include <cstdlib>
-#include <signal.h>
-#include <stdexcept>
-#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 
+// Deadline based search timer. The searching thread polls Lapsed(), which
+// reads the monotonic clock only once every POLL_INTERVAL calls, so a lapsed
+// deadline is noticed within POLL_INTERVAL polls (a few dozen nodes). Other
+// threads can stop the search at any time with Expire() or Invalidate().
+//
+// The timer can also stop the search after a fixed number of nodes instead,
+// which makes the search independent of the clock and its results
+// reproducible.
+//
+// All state that other threads touch is atomic: a pondering or helper thread
+// may be searching with a timer while the main thread stops it.
 class Timer {
 public:
-  Timer() {
-    struct sigevent sigx;
-    sigx.sigev_notify = SIGEV_THREAD;
-    sigx.sigev_value.sival_ptr = this;
-    sigx.sigev_notify_function = &Timer::Handler;
-    sigx.sigev_notify_attributes = NULL;
-    if (timer_create(CLOCK_REALTIME, &sigx, &timer_id_) == -1) {
-      throw std::runtime_error("Error: timer_create");
-    }
-  }
+  // Number of calls to Lapsed() between two reads of the clock.
+  static constexpr unsigned POLL_INTERVAL = 64;
 
-  ~Timer() noexcept(false) {
-    RemoveTimer();
-    if (timer_delete(timer_id_) == -1) {
-      throw std::runtime_error("Error: timer_delete");
-    }
-  }
+  Timer() = default;
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
 
+  // Clears the deadline and the node limit, and undoes Expire().
   void Reset() {
-    RemoveTimer();
-    timer_expired_ = false;
+    nodes_ = 0U;
+    node_limit_ = 0U;
+    deadline_.store(NO_DEADLINE, std::memory_order_relaxed);
+    expired_at_.store(NO_DEADLINE, std::memory_order_relaxed);
+    polls_.store(0U, std::memory_order_relaxed);
+    expired_.store(false, std::memory_order_release);
   }
 
+  // Sets the deadline to 'centis' centiseconds from now.
   void Run(long centis) {
     if (Lapsed()) {
       return;
     }
     if (centis <= 0) {
-      timer_expired_ = true;
+      expired_.store(true, std::memory_order_release);
       return;
     }
-    struct itimerspec val;
-    val.it_value.tv_sec = centis / 100;
-    val.it_value.tv_nsec = (centis % 100) * 10000000;
-    val.it_interval.tv_sec = 0;
-    val.it_interval.tv_nsec = 0;
-    if (timer_settime(timer_id_, 0, &val, 0) == -1) {
-      throw std::runtime_error("Error: timer_settime");
+    deadline_.store(Now() + centis * 10000, std::memory_order_relaxed);
+  }
+
+  // Lapses the timer once CountNode() has been called 'max_nodes' times.
+  void SetNodeLimit(uint64_t max_nodes) { node_limit_ = max_nodes; }
+
+  // Called by the searching thread for every node searched.
+  void CountNode() {
+    if (++nodes_ == node_limit_) {
+      Expire();
     }
   }
 
-  void Invalidate() { timer_invalidated_ = true; }
+  // Number of nodes counted since the last Reset().
+  uint64_t NodesCounted() const { return nodes_; }
 
-  bool Lapsed() const { return timer_expired_ || timer_invalidated_; }
+  // Stops the search for good. Used to stop pondering.
+  void Invalidate() { invalidated_.store(true, std::memory_order_release); }
 
-private:
-  static void Handler(sigval_t sival) {
-    reinterpret_cast<Timer*>(sival.sival_ptr)->Expire();
-  }
+  // Expires the timer immediately. Unlike Invalidate(), this is undone by the
+  // next call to Reset().
+  void Expire() { expired_.store(true, std::memory_order_release); }
 
-  void Expire() {
-    RemoveTimer();
-    timer_expired_ = true;
+  bool Lapsed() const {
+    if (expired_.load(std::memory_order_acquire) ||
+        invalidated_.load(std::memory_order_acquire)) {
+      return true;
+    }
+    // The poll count is only a throttle, so a lost update when two threads
+    // poll the same timer is harmless.
+    const unsigned polls = polls_.load(std::memory_order_relaxed) + 1;
+    polls_.store(polls, std::memory_order_relaxed);
+    if (polls % POLL_INTERVAL != 0) {
+      return false;
+    }
+    const int64_t deadline = deadline_.load(std::memory_order_relaxed);
+    if (deadline == NO_DEADLINE) {
+      return false;
+    }
+    const int64_t now = Now();
+    if (now < deadline) {
+      return false;
+    }
+    expired_at_.store(now, std::memory_order_relaxed);
+    expired_.store(true, std::memory_order_release);
+    return true;
   }
 
-  void RemoveTimer() {
-    struct itimerspec val;
-    val.it_value.tv_sec = 0;
-    val.it_value.tv_nsec = 0;
-    val.it_interval.tv_sec = 0;
-    val.it_interval.tv_nsec = 0;
-    if (timer_settime(timer_id_, 0, &val, 0) == -1) {
-      throw std::runtime_error("Error: timer_settime");
+  // Microseconds between the deadline and the poll that noticed it, or -1 if
+  // the deadline has not been noticed since the last Reset().
+  long LatencyMicros() const {
+    const int64_t expired_at = expired_at_.load(std::memory_order_relaxed);
+    if (expired_at == NO_DEADLINE) {
+      return -1;
     }
+    return expired_at - deadline_.load(std::memory_order_relaxed);
   }
 
-  timer_t timer_id_;
-  bool timer_expired_ = false;
-  bool timer_invalidated_ = false;
+private:
+  static constexpr int64_t NO_DEADLINE = INT64_MAX;
+
+  // Monotonic time in microseconds.
+  static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // Only accessed by the searching thread.
+  uint64_t nodes_ = 0U;
+  uint64_t node_limit_ = 0U;
+
+  std::atomic<int64_t> deadline_{NO_DEADLINE};
+  mutable std::atomic<int64_t> expired_at_{NO_DEADLINE};
+  mutable std::atomic<unsigned> polls_{0U};
+  mutable std::atomic<bool> expired_{false};
+  std::atomic<bool> invalidated_{false};
 };
 
 #endif
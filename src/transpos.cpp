@@ -3,79 +3,369 @@
 #include "stopwatch.h"
 #include "zobrist.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
 #include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
-TranspositionTable::TranspositionTable(int size)
-    : size_(size), transpos1_hits_(0U), transpos2_hits_(0U),
-      transpos_misses_(0U) {
-  std::cout << "# Transposition table memory usage: "
-            << (size_ * sizeof(TranspositionTable2Entry)) / (1U << 20) << " MB"
-            << std::endl;
-  tentries_ = new TranspositionTable2Entry[size_];
+namespace {
+
+constexpr size_t HUGE_PAGE_SIZE = 2U << 20;
+
+// Tables smaller than this are cleared by a single thread.
+constexpr size_t MIN_PARALLEL_CLEAR_BYTES = 64U << 20;
+
+// Layout of TranspositionTableSlot::data.
+// Bit 0-15: Best move (EncodedMove)
+// Bit 16-31: Score
+// Bit 32-39: Depth
+// Bit 40-41: Node type
+// Bit 42-47: Search generation in which the entry was last stored
+// Bit 63: Set for all slots that hold an entry, so that data is never 0 for a
+//         filled slot.
+constexpr U64 VALID_BIT = 1ULL << 63;
+
+constexpr int GENERATION_SHIFT = 42;
+constexpr unsigned int GENERATION_MASK = 0x3F;
+
+// Number of plies of depth an entry is worth less for every search generation
+// it has not been used in.
+constexpr int AGE_WEIGHT = 4;
+
+// An entry for the same position is kept instead of an inexact one searched
+// more than this many plies shallower, so that quiescence search results
+// don't replace deep search results.
+constexpr int SAME_POSITION_DEPTH_MARGIN = 2;
+
+int Depth(U64 data) { return (data >> 32) & 0xFF; }
+
+NodeType NodeTypeOf(U64 data) {
+  return static_cast<NodeType>((data >> 40) & 0x3);
+}
+
+unsigned int Generation(U64 data) {
+  return (data >> GENERATION_SHIFT) & GENERATION_MASK;
+}
+
+U64 WithGeneration(U64 data, unsigned int generation) {
+  return (data & ~(U64(GENERATION_MASK) << GENERATION_SHIFT)) |
+         (U64(generation & GENERATION_MASK) << GENERATION_SHIFT);
+}
+
+U64 PackData(int score, NodeType node_type, int depth, Move best_move,
+             unsigned int generation) {
+  return VALID_BIT |
+         (static_cast<U64>(generation & GENERATION_MASK) << GENERATION_SHIFT) |
+         (static_cast<U64>(node_type & 0x3) << 40) |
+         (static_cast<U64>(depth & 0xFF) << 32) |
+         (static_cast<U64>(static_cast<uint16_t>(score)) << 16) |
+         best_move.encoded_move();
+}
+
+TranspositionTableEntry UnpackData(U64 data, U64 zkey) {
+  TranspositionTableEntry tentry;
+  tentry.score = static_cast<short int>((data >> 16) & 0xFFFF);
+  tentry.node_type = NodeTypeOf(data);
+  tentry.depth = Depth(data);
+  tentry.best_move = Move(static_cast<EncodedMove>(data & 0xFFFF));
+  tentry.zkey = zkey;
+  return tentry;
+}
+
+// A snapshot file is a SnapshotHeader followed by 'num_entries' pairs of
+// zobrist key and data words.
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t variant;
+  U64 zobrist_fingerprint;
+  U64 num_entries;
+};
+
+constexpr char SNAPSHOT_MAGIC[8] = {'N', 'K', 'T', 'T', 'S', 'N', 'A', 'P'};
+
+// Increment when the data layout or the meaning of scores changes, so that
+// stale snapshots are discarded.
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+bool IsSolved(U64 data) {
+  const TranspositionTableEntry tentry = UnpackData(data, 0ULL);
+  return tentry.node_type == EXACT_NODE &&
+         (tentry.score == WIN || tentry.score == -WIN);
+}
+
+} // namespace
+
+size_t TranspositionTable::NumClusters(size_t size) {
+  size_t num_clusters = 1;
+  while (num_clusters * 2 <= size / CLUSTER_SIZE) {
+    num_clusters *= 2;
+  }
+  return num_clusters;
+}
+
+size_t TranspositionTable::SizeForMegabytes(int megabytes) {
+  return (static_cast<size_t>(megabytes) << 20) /
+         sizeof(TranspositionTableSlot);
+}
+
+TranspositionTable::TranspositionTable(size_t size)
+    : num_clusters_(NumClusters(size)), mask_(num_clusters_ - 1),
+      generation_(0U), transpos_hits_(0U), transpos_misses_(0U) {
+  Allocate();
+  Clear();
+}
+
+TranspositionTable::~TranspositionTable() {
+  if (region_) {
+    munmap(region_, region_bytes_);
+  } else {
+    delete[] clusters_;
+  }
+}
+
+void TranspositionTable::Allocate() {
+  const size_t bytes = num_clusters_ * sizeof(TranspositionTableCluster);
+  if (bytes >= HUGE_PAGE_SIZE) {
+    // Over-allocate so that the table can start at a huge page boundary.
+    region_bytes_ = bytes + HUGE_PAGE_SIZE;
+    region_ = mmap(nullptr, region_bytes_, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region_ == MAP_FAILED) {
+      region_ = nullptr;
+    }
+  }
+  if (!region_) {
+    clusters_ = new TranspositionTableCluster[num_clusters_];
+    std::cout << "# Transposition table memory usage: " << (bytes >> 20)
+              << " MB" << std::endl;
+    return;
+  }
+  const uintptr_t aligned =
+      (reinterpret_cast<uintptr_t>(region_) + HUGE_PAGE_SIZE - 1) &
+      ~(HUGE_PAGE_SIZE - 1);
+  clusters_ = reinterpret_cast<TranspositionTableCluster*>(aligned);
+  bool huge_pages = false;
+#ifdef MADV_HUGEPAGE
+  // Probes are random accesses all over the table, so with 4K pages nearly
+  // every probe also misses the TLB. madvise fails if transparent huge pages
+  // are disabled, in which case regular pages are used.
+  huge_pages = madvise(clusters_, bytes, MADV_HUGEPAGE) == 0;
+#endif
+  std::cout << "# Transposition table memory usage: " << (bytes >> 20)
+            << " MB" << (huge_pages ? " (huge pages)" : "") << std::endl;
 }
 
-TranspositionTable::~TranspositionTable() { Reset(); }
+void TranspositionTable::Clear() {
+  const size_t bytes = num_clusters_ * sizeof(TranspositionTableCluster);
+  int num_threads = 1;
+  if (bytes >= MIN_PARALLEL_CLEAR_BYTES) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  // Constructing the clusters in place also commits the pages of a freshly
+  // mapped table, so that the cost is not paid by the search.
+  auto clear = [this, num_threads](int i) {
+    const size_t begin = num_clusters_ * i / num_threads;
+    const size_t end = num_clusters_ * (i + 1) / num_threads;
+    for (size_t j = begin; j < end; ++j) {
+      new (&clusters_[j]) TranspositionTableCluster();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(clear, i);
+  }
+  clear(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
 
-TranspositionTableEntry* TranspositionTable::Get(U64 zkey) {
-  TranspositionTable2Entry* tentry = &tentries_[hash(zkey)];
-  if (tentry->t1.valid && tentry->t1.zkey == zkey) {
-    ++transpos1_hits_;
-    return &tentry->t1;
+std::optional<TranspositionTableEntry>
+TranspositionTable::Probe(U64 zkey, const TranspositionTableSlot* t) const {
+  const U64 data = t->data.load(std::memory_order_relaxed);
+  const U64 key = t->key.load(std::memory_order_relaxed);
+  if ((data & VALID_BIT) && (key ^ data) == zkey) {
+    return UnpackData(data, zkey);
   }
-  if (tentry->t2.valid && tentry->t2.zkey == zkey) {
-    ++transpos2_hits_;
-    return &tentry->t2;
+  return std::nullopt;
+}
+
+std::optional<TranspositionTableEntry> TranspositionTable::Get(U64 zkey) {
+  for (TranspositionTableSlot& t : cluster(zkey).slots) {
+    if (auto tentry = Probe(zkey, &t); tentry) {
+      return tentry;
+    }
   }
-  ++transpos_misses_;
-  return nullptr;
+  return std::nullopt;
 }
 
 void TranspositionTable::Put(int score, NodeType node_type, int depth, U64 zkey,
                              Move best_move) {
-  TranspositionTable2Entry* tentry = &tentries_[hash(zkey)];
-  TranspositionTableEntry* t = nullptr;
-  if (!tentry->t1.valid || tentry->t1.depth < depth) {
-    t = &tentry->t1;
-  } else {
-    t = &tentry->t2;
+  Store(PackData(score, node_type, depth, best_move, generation()), zkey);
+}
+
+void TranspositionTable::Store(U64 data, U64 zkey) {
+  // Overwrite the entry for the same position or an empty slot if there is
+  // one, otherwise replace the entry with the least depth after discounting
+  // the number of searches it has not been used in.
+  const unsigned int generation = Generation(data);
+  TranspositionTableSlot* replace = nullptr;
+  int replace_value = 0;
+  for (TranspositionTableSlot& t : cluster(zkey).slots) {
+    const U64 slot_data = t.data.load(std::memory_order_relaxed);
+    const U64 key = t.key.load(std::memory_order_relaxed);
+    if (!(slot_data & VALID_BIT)) {
+      replace = &t;
+      break;
+    }
+    if ((key ^ slot_data) == zkey) {
+      // A much deeper entry for the same position is worth more than a
+      // shallow bound. It is only moved to the current generation.
+      if (Depth(data) + SAME_POSITION_DEPTH_MARGIN < Depth(slot_data) &&
+          (NodeTypeOf(data) != EXACT_NODE ||
+           NodeTypeOf(slot_data) == EXACT_NODE)) {
+        if (Generation(slot_data) == generation) {
+          return;
+        }
+        data = WithGeneration(slot_data, generation);
+      }
+      replace = &t;
+      break;
+    }
+    const int age = (generation - Generation(slot_data)) & GENERATION_MASK;
+    const int value = Depth(slot_data) - AGE_WEIGHT * age;
+    if (replace == nullptr || value < replace_value) {
+      replace = &t;
+      replace_value = value;
+    }
   }
-  Set(score, node_type, depth, zkey, best_move, t);
+  Set(data, zkey, replace);
 }
 
-void TranspositionTable::Set(int score, NodeType node_type, int depth, U64 zkey,
-                             Move best_move, TranspositionTableEntry* t) {
-  t->valid = true;
-  t->score = score;
-  t->node_type = node_type;
-  t->depth = depth;
-  t->zkey = zkey;
-  t->best_move = best_move;
+void TranspositionTable::Set(U64 data, U64 zkey, TranspositionTableSlot* t) {
+  t->data.store(data, std::memory_order_relaxed);
+  t->key.store(zkey ^ data, std::memory_order_relaxed);
 }
 
-void TranspositionTable::Reset() { delete tentries_; }
+bool TranspositionTable::Save(const std::string& filename, Variant variant,
+                              int min_depth) const {
+  std::vector<U64> words;
+  for (size_t i = 0; i < num_clusters_; ++i) {
+    for (const TranspositionTableSlot& t : clusters_[i].slots) {
+      const U64 data = t.data.load(std::memory_order_relaxed);
+      const U64 key = t.key.load(std::memory_order_relaxed);
+      if ((data & VALID_BIT) && (Depth(data) >= min_depth || IsSolved(data))) {
+        words.push_back(key ^ data);
+        words.push_back(WithGeneration(data, 0U));
+      }
+    }
+  }
+  SnapshotHeader header;
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.variant = static_cast<uint32_t>(variant);
+  header.zobrist_fingerprint = zobrist::Fingerprint();
+  header.num_entries = words.size() / 2;
+
+  // Write to a temporary file first so that an interrupted write does not
+  // destroy the previous snapshot.
+  const std::string tmp_filename = filename + ".tmp";
+  std::ofstream ofs(tmp_filename, std::ofstream::binary);
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  ofs.write(reinterpret_cast<const char*>(words.data()),
+            words.size() * sizeof(U64));
+  ofs.close();
+  if (!ofs || std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    std::cout << "# Failed to write transposition table snapshot " << filename
+              << std::endl;
+    return false;
+  }
+  std::cout << "# Saved " << header.num_entries
+            << " transposition table entries to " << filename << std::endl;
+  return true;
+}
+
+bool TranspositionTable::Load(const std::string& filename, Variant variant) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+    close(fd);
+    return false;
+  }
+  const size_t file_size = st.st_size;
+  void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+
+  const SnapshotHeader* header = static_cast<const SnapshotHeader*>(mapped);
+  const bool valid =
+      std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+      header->version == SNAPSHOT_VERSION &&
+      header->variant == static_cast<uint32_t>(variant) &&
+      header->zobrist_fingerprint == zobrist::Fingerprint() &&
+      file_size ==
+          sizeof(SnapshotHeader) + header->num_entries * 2 * sizeof(U64);
+  if (valid) {
+    const U64* words = reinterpret_cast<const U64*>(header + 1);
+    const unsigned int generation = this->generation();
+    for (U64 i = 0; i < header->num_entries; ++i) {
+      Store(WithGeneration(words[2 * i + 1], generation), words[2 * i]);
+    }
+    std::cout << "# Loaded " << header->num_entries
+              << " transposition table entries from " << filename
+              << std::endl;
+  } else {
+    std::cout << "# Ignoring incompatible transposition table snapshot "
+              << filename << std::endl;
+  }
+  munmap(mapped, file_size);
+  return valid;
+}
 
 double TranspositionTable::UtilizationFactor() const {
-  unsigned int num_filled_entries = 0;
-  for (int i = 0; i < size_; ++i) {
-    if (tentries_[i].t1.valid || tentries_[i].t2.valid) {
-      ++num_filled_entries;
+  size_t num_filled_entries = 0;
+  for (size_t i = 0; i < num_clusters_; ++i) {
+    for (const TranspositionTableSlot& t : clusters_[i].slots) {
+      if (t.data.load(std::memory_order_relaxed) & VALID_BIT) {
+        ++num_filled_entries;
+      }
     }
   }
-  return (100.0 * num_filled_entries) / size_;
+  return (100.0 * num_filled_entries) / (num_clusters_ * CLUSTER_SIZE);
+}
+
+void TranspositionTable::AddStats(unsigned hits, unsigned misses) {
+  transpos_hits_.fetch_add(hits, std::memory_order_relaxed);
+  transpos_misses_.fetch_add(misses, std::memory_order_relaxed);
 }
 
 void TranspositionTable::LogStats() const {
   using std::cout;
   using std::endl;
-  cout << "# Transpos 1 hits:\t" << transpos1_hits_ << endl;
-  cout << "# Transpos 2 hits:\t" << transpos2_hits_ << endl;
-  cout << "# Transpos misses:\t" << transpos_misses_ << endl;
+  const unsigned int transpos_hits = transpos_hits_;
+  const unsigned int transpos_misses = transpos_misses_;
+  cout << "# Transpos hits:\t" << transpos_hits << endl;
+  cout << "# Transpos misses:\t" << transpos_misses << endl;
   cout << "# Transpos utilization factor:\t" << UtilizationFactor() << " %"
        << endl;
-  if (transpos1_hits_ + transpos2_hits_ + transpos_misses_ > 0) {
+  if (transpos_hits + transpos_misses > 0) {
     cout << "# Percentage of hits:\t"
-         << (100.0 * (transpos1_hits_ + transpos2_hits_)) /
-                (transpos1_hits_ + transpos2_hits_ + transpos_misses_)
-         << " %" << endl;
+         << (100.0 * transpos_hits) / (transpos_hits + transpos_misses) << " %"
+         << endl;
   }
 }
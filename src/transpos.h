@@ -5,11 +5,13 @@
 #include "move.h"
 #include "zobrist.h"
 
+#include <atomic>
+#include <cstddef>
 #include <cstdio>
+#include <optional>
+#include <string>
 
 struct TranspositionTableEntry {
-  TranspositionTableEntry() : valid(false) {}
-  bool valid;
   short int score;
   NodeType node_type;
   unsigned char
@@ -18,38 +20,110 @@ struct TranspositionTableEntry {
   U64 zkey;
 };
 
-struct TranspositionTable2Entry {
-  TranspositionTableEntry t1; // depth preferred
-  TranspositionTableEntry t2; // always replace
+// A transposition table entry packed into two words so that it can be read
+// and written concurrently without locks. 'data' holds the entry fields and
+// 'key' holds the zobrist key XOR'ed with 'data'. If two threads write the
+// same slot at once, a reader may see the words of different writes, but then
+// key ^ data no longer gives back the probed zobrist key and the slot is
+// treated as a miss instead of returning another position's entry.
+struct TranspositionTableSlot {
+  std::atomic<U64> key;
+  std::atomic<U64> data;
 };
 
+// A bucket of entries that fills exactly one cache line, so a probe touches
+// a single line of memory.
+constexpr int CLUSTER_SIZE = 4;
+
+struct alignas(64) TranspositionTableCluster {
+  TranspositionTableSlot slots[CLUSTER_SIZE];
+};
+
+// Transposition table shared by all threads searching a position (pondering
+// and Lazy SMP helpers). Get() and Put() may be called concurrently.
 class TranspositionTable {
 public:
-  TranspositionTable(int size);
+  // 'size' is the number of entries. It is rounded down to a power of two
+  // multiple of CLUSTER_SIZE. Large tables are backed by transparent huge
+  // pages when the kernel supports them.
+  TranspositionTable(size_t size);
   ~TranspositionTable();
-  TranspositionTableEntry* Get(U64 zkey);
+
+  // Returns the number of entries that fit in given memory budget.
+  static size_t SizeForMegabytes(int megabytes);
+
+  // Returns a copy of the entry for given zobrist key, if any. Probing does
+  // not write to the table.
+  std::optional<TranspositionTableEntry> Get(U64 zkey);
   void Put(int score, NodeType node_type, int depth, U64 zkey, Move best_move);
-  void Reset();
+
+  // Starts loading the cluster for given zobrist key into the cache, so that
+  // a later Get() or Put() for the key does not have to wait for memory.
+  void Prefetch(U64 zkey) const { __builtin_prefetch(&cluster(zkey)); }
+
+  // Removes all entries. Big tables are cleared by several threads in
+  // parallel.
+  void Clear();
+
+  // Writes entries searched to at least 'min_depth' and all entries for
+  // positions proven to be won or lost to given file. Returns false on
+  // failure.
+  bool Save(const std::string& filename, Variant variant, int min_depth) const;
+
+  // Adds the entries of a snapshot written by Save() to the table. The
+  // snapshot is rejected if it was written for another variant or with other
+  // zobrist keys. Returns true if the snapshot was loaded.
+  bool Load(const std::string& filename, Variant variant);
+
+  // Starts a new search generation. Entries that were not stored since are
+  // aged, and older entries are replaced before shallower ones from the
+  // current search.
+  void NewSearch() { generation_.fetch_add(1U, std::memory_order_relaxed); }
+
+  // Adds probe counts of a finished search to the totals logged by
+  // LogStats(). Get() does not count probes itself, so that threads sharing
+  // the table don't contend on the counters.
+  void AddStats(unsigned hits, unsigned misses);
 
   void LogStats() const;
 
 private:
-  void Set(int score, NodeType node_type, int depth, U64 zkey, Move best_move,
-           TranspositionTableEntry* t);
+  std::optional<TranspositionTableEntry>
+  Probe(U64 zkey, const TranspositionTableSlot* t) const;
+
+  // Stores packed entry data in the cluster for given zobrist key.
+  void Store(U64 data, U64 zkey);
+
+  void Set(U64 data, U64 zkey, TranspositionTableSlot* t);
 
-  int hash(const U64 key) const { return key % size_; }
+  unsigned int generation() const {
+    return generation_.load(std::memory_order_relaxed);
+  }
 
-  int hash2(const U64 key) const { return (key >> 1) % size_; }
+  TranspositionTableCluster& cluster(const U64 key) const {
+    return clusters_[key & mask_];
+  }
 
   double UtilizationFactor() const;
 
-  const int size_;
+  static size_t NumClusters(size_t size);
+
+  void Allocate();
+
+  const size_t num_clusters_;
+  const U64 mask_;
+
+  TranspositionTableCluster* clusters_;
+
+  // Memory mapped region holding clusters_, or nullptr if clusters_ was
+  // allocated with new[].
+  void* region_ = nullptr;
+  size_t region_bytes_ = 0;
 
-  TranspositionTable2Entry* tentries_;
+  std::atomic<unsigned int> generation_;
 
-  unsigned int transpos1_hits_;
-  unsigned int transpos2_hits_;
-  unsigned int transpos_misses_;
+  std::atomic<unsigned int> transpos_hits_;
+  std::atomic<unsigned int> transpos_misses_;
 };
 
 #endif
@@ -0,0 +1,61 @@
+#include "common.h"
+#include "move.h"
+#include "stopwatch.h"
+#include "transpos.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Measures store and probe throughput of the transposition table.
+// Usage: transpos_perf [<num entries> [<num operations>]]
+int main(int argc, char** argv) {
+  const int num_entries = (argc > 1) ? atoi(argv[1]) : (1 << 22);
+  const int num_ops = (argc > 2) ? atoi(argv[2]) : (1 << 24);
+
+  std::vector<U64> keys(num_ops);
+  U64 x = 0x9E3779B97F4A7C15ULL;
+  for (U64& key : keys) {
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    key = x * 0x2545F4914F6CDD1DULL;
+  }
+
+  TranspositionTable transpos(num_entries);
+  StopWatch stop_watch;
+
+  stop_watch.Start();
+  for (int i = 0; i < num_ops; ++i) {
+    const U64 key = keys[i];
+    transpos.Put(key % 1000, EXACT_NODE, key % 32, key,
+                 Move(key % 64, (key >> 6) % 64));
+  }
+  stop_watch.Stop();
+  const double put_secs = stop_watch.ElapsedTime() / 100.0;
+
+  // Half the probes are for keys that were stored most recently and half for
+  // keys that were never stored.
+  int hits = 0;
+  stop_watch.Start();
+  for (int i = 0; i < num_ops; ++i) {
+    const U64 key = (i % 2) ? keys[num_ops - 1 - i / 2] : ~keys[i];
+    if (transpos.Get(key)) {
+      ++hits;
+    }
+  }
+  stop_watch.Stop();
+  const double get_secs = stop_watch.ElapsedTime() / 100.0;
+
+  printf("+-----------+------------------+------------------+\n");
+  printf("| Operation | Elapsed time (s) |    Mops / sec    |\n");
+  printf("+-----------+------------------+------------------+\n");
+  printf("| Put       | %16.3f | %16.3f |\n", put_secs,
+         num_ops / put_secs / 1e6);
+  printf("| Get       | %16.3f | %16.3f |\n", get_secs,
+         num_ops / get_secs / 1e6);
+  printf("+-----------+------------------+------------------+\n");
+  printf("Probe hit rate: %.2f %%\n", (100.0 * hits) / num_ops);
+  return 0;
+}
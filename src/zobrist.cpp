@@ -3,7 +3,6 @@
 #include "piece.h"
 
 #include <array>
-#include <cstdlib>
 #include <iostream>
 
 namespace {
@@ -12,45 +11,53 @@ constexpr int PIECE_MAX = 7;
 constexpr int COLOR_MAX = 3;
 constexpr int SQUARE_MAX = 64;
 
-U64 RandU64() {
-  U64 r = rand();
-  r <<= 32;
-  r |= rand();
-  return r;
+// splitmix64 pseudo random number generator. The keys only depend on the seed
+// and are the same on every build and host, so data keyed by zobrist keys can
+// be saved and reused by other binaries.
+constexpr U64 SplitMix64(U64* state) {
+  *state += 0x9E3779B97F4A7C15ULL;
+  U64 z = *state;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
 }
 
 template <typename T, int A, int B, int C>
 using Array3d = std::array<std::array<std::array<T, C>, B>, A>;
 
-const Array3d<U64, PIECE_MAX, COLOR_MAX, SQUARE_MAX> zobrist_ = []() {
-  Array3d<U64, PIECE_MAX, COLOR_MAX, SQUARE_MAX> zobrist;
+struct ZobristKeys {
+  Array3d<U64, PIECE_MAX, COLOR_MAX, SQUARE_MAX> pieces;
+  std::array<U64, SQUARE_MAX> ep;
+  std::array<U64, 16> castling;
+  U64 turn;
+};
+
+constexpr ZobristKeys GenerateKeys() {
+  U64 state = 0x6E616B7368617472ULL;
+  ZobristKeys keys{};
   for (int i = 0; i < PIECE_MAX; ++i) {
     for (int j = 0; j < COLOR_MAX; ++j) {
       for (int k = 0; k < SQUARE_MAX; ++k) {
-        zobrist[i][j][k] = RandU64();
+        keys.pieces[i][j][k] = SplitMix64(&state);
       }
     }
   }
-  return zobrist;
-}();
-
-const std::array<U64, SQUARE_MAX> ep_ = []() {
-  std::array<U64, SQUARE_MAX> ep;
   for (int i = 0; i < SQUARE_MAX; ++i) {
-    ep[i] = RandU64();
+    keys.ep[i] = SplitMix64(&state);
   }
-  return ep;
-}();
-
-const std::array<U64, 16> castling_ = []() {
-  std::array<U64, 16> castling;
   for (int i = 0; i < 16; ++i) {
-    castling[i] = RandU64();
+    keys.castling[i] = SplitMix64(&state);
   }
-  return castling;
-}();
+  keys.turn = SplitMix64(&state);
+  return keys;
+}
 
-const U64 turn_ = RandU64();
+constexpr ZobristKeys keys_ = GenerateKeys();
+
+constexpr const auto& zobrist_ = keys_.pieces;
+constexpr const auto& ep_ = keys_.ep;
+constexpr const auto& castling_ = keys_.castling;
+constexpr U64 turn_ = keys_.turn;
 
 } // namespace
 
@@ -68,6 +75,28 @@ U64 Castling(unsigned index) { return castling_[index]; }
 
 U64 Castling(unsigned char castle) { return castling_[castle]; }
 
+U64 Fingerprint() {
+  U64 fingerprint = 0;
+  auto add = [&fingerprint](U64 key) {
+    fingerprint = (fingerprint ^ key) * 0x100000001B3ULL;
+  };
+  for (const auto& color_keys : zobrist_) {
+    for (const auto& square_keys : color_keys) {
+      for (U64 key : square_keys) {
+        add(key);
+      }
+    }
+  }
+  for (U64 key : ep_) {
+    add(key);
+  }
+  for (U64 key : castling_) {
+    add(key);
+  }
+  add(turn_);
+  return fingerprint;
+}
+
 void PrintZobrist() {
   for (int i = 0; i < PIECE_MAX; ++i) {
     for (int j = 0; j < COLOR_MAX; ++j) {
@@ -15,6 +15,10 @@ U64 Turn();
 U64 EP(int sq);
 
 U64 Castling(unsigned char castle);
+
+// Returns a hash of all the zobrist keys. Data keyed by zobrist keys that is
+// saved to disk can only be reused by a program with the same fingerprint.
+U64 Fingerprint();
 } // namespace zobrist
 
 #endif